@@ -0,0 +1,146 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ *
+ * Generated by tools/embed_assets.py from tools/web, do not edit.
+ */
+
+#ifndef ESP_KNX_IP_ASSETS_H
+#define ESP_KNX_IP_ASSETS_H
+
+// Changes with the content, appended to the asset urls so cached copies are replaced after an update
+#define __ASSETS_VERSION "4941cfaf"
+
+// style.css, 2475 bytes minified, 947 bytes compressed
+#define __ASSET_STYLE_CSS_TYPE "text/css"
+static const uint8_t __asset_style_css[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x56, 0x51, 0x6f, 0xdb, 0x36,
+  0x10, 0xfe, 0x2b, 0x42, 0x8a, 0x00, 0x6d, 0x27, 0x0a, 0xb2, 0x6a, 0x57, 0x09, 0x85, 0x05, 0xd8,
+  0x06, 0x14, 0xdb, 0x43, 0xf6, 0xd0, 0x60, 0x4f, 0x43, 0x1f, 0x28, 0xf2, 0x64, 0x11, 0xa1, 0x49,
+  0x81, 0xa4, 0x63, 0x7b, 0x82, 0xff, 0x7b, 0x4f, 0x94, 0x6c, 0x4b, 0xb1, 0x93, 0xa6, 0xd8, 0x8b,
+  0x2d, 0x51, 0x1f, 0xbf, 0xfb, 0xee, 0xe3, 0xdd, 0x49, 0x1f, 0xe3, 0x8f, 0x94, 0x96, 0x50, 0x19,
+  0x0b, 0xdd, 0x15, 0xab, 0x3c, 0xd8, 0xb6, 0x34, 0x5b, 0xe2, 0xe4, 0x7f, 0x52, 0x2f, 0x69, 0x69,
+  0xac, 0x00, 0x4b, 0x70, 0x65, 0x5f, 0x1a, 0xb1, 0x6b, 0x57, 0xcc, 0x2e, 0xa5, 0xa6, 0x69, 0x51,
+  0x19, 0xed, 0x49, 0xc5, 0x56, 0x52, 0xed, 0x28, 0x61, 0x4d, 0xa3, 0x80, 0xb8, 0x9d, 0xf3, 0xb0,
+  0x8a, 0x7f, 0x57, 0x52, 0x3f, 0xde, 0x33, 0xfe, 0x10, 0x6e, 0xbf, 0x20, 0x2e, 0xbe, 0x7a, 0x80,
+  0xa5, 0x81, 0xe8, 0x9f, 0xbf, 0xae, 0xe2, 0xaf, 0xa6, 0x34, 0xde, 0xc4, 0x57, 0x7f, 0x82, 0x7a,
+  0x02, 0x2f, 0x39, 0x8b, 0xfe, 0x86, 0x35, 0x5c, 0xc5, 0xbf, 0x59, 0xc9, 0x54, 0xec, 0x98, 0x76,
+  0xc4, 0x81, 0x95, 0x55, 0x1f, 0x00, 0x55, 0x00, 0x9d, 0x59, 0x58, 0x15, 0x48, 0x0a, 0xa4, 0x06,
+  0xb9, 0xac, 0x3d, 0x9d, 0x25, 0x8b, 0x82, 0x1b, 0x65, 0x2c, 0x7d, 0x97, 0xcd, 0xb2, 0x45, 0x76,
+  0x5b, 0x94, 0x8c, 0x3f, 0x2e, 0xad, 0x59, 0x6b, 0x41, 0x86, 0x07, 0x55, 0x55, 0xed, 0xeb, 0x2c,
+  0xae, 0xe7, 0x83, 0x64, 0xe2, 0x4d, 0x83, 0xb2, 0x87, 0x1b, 0xd4, 0xe0, 0xcd, 0x8a, 0x26, 0x8b,
+  0x8e, 0x3a, 0x44, 0xda, 0xf4, 0xd4, 0x8b, 0x34, 0x7d, 0x16, 0x2a, 0x43, 0x9a, 0xf6, 0x24, 0x26,
+  0xc3, 0x1d, 0x7b, 0x64, 0x1d, 0xc9, 0x0b, 0x2c, 0x7b, 0xb4, 0x70, 0x75, 0xb4, 0x67, 0x9f, 0x70,
+  0x7c, 0xce, 0x90, 0xc8, 0x92, 0x4a, 0xad, 0xa5, 0x68, 0x37, 0x52, 0xf8, 0x9a, 0xce, 0xd2, 0xf4,
+  0xba, 0x68, 0x98, 0x10, 0xe8, 0x2d, 0xb1, 0x7d, 0x84, 0x45, 0xb3, 0x3d, 0x2e, 0x29, 0xa8, 0xfa,
+  0x95, 0x7d, 0x62, 0xcd, 0xa6, 0x15, 0xd2, 0x35, 0x8a, 0xed, 0x68, 0xa5, 0x60, 0x5b, 0x74, 0x3f,
+  0x64, 0x63, 0x59, 0x43, 0xbb, 0x9f, 0x43, 0x26, 0x3d, 0x09, 0x09, 0x2c, 0x97, 0x92, 0x1b, 0xd6,
+  0x02, 0x31, 0xe9, 0x99, 0xd1, 0x21, 0xc2, 0xd6, 0xde, 0xb4, 0x1d, 0x23, 0x4d, 0xa3, 0x34, 0xea,
+  0xee, 0x10, 0x89, 0xf4, 0x3f, 0xab, 0x52, 0xea, 0x66, 0xed, 0x49, 0x67, 0x7d, 0xd3, 0x36, 0xc6,
+  0x49, 0x2f, 0x8d, 0xa6, 0x16, 0x14, 0xf3, 0xf2, 0x09, 0x8a, 0xd7, 0xf4, 0x33, 0x25, 0x97, 0x9a,
+  0x48, 0x2c, 0x11, 0x47, 0x9d, 0xb7, 0xe0, 0x79, 0x3d, 0xa1, 0x23, 0x8d, 0x85, 0x06, 0xb4, 0x88,
+  0x27, 0x8b, 0x58, 0x69, 0x67, 0x6b, 0x52, 0x63, 0xc5, 0xf8, 0x89, 0x59, 0x53, 0x26, 0x0f, 0xdb,
+  0xe9, 0xe3, 0x49, 0x70, 0x0e, 0x1a, 0x8b, 0xfe, 0x90, 0x1c, 0x4d, 0x3e, 0xe5, 0x9d, 0x71, 0x51,
+  0x92, 0x8f, 0xfd, 0x1b, 0x3c, 0x4d, 0xdf, 0x58, 0x96, 0xf3, 0xdb, 0x45, 0xba, 0xc8, 0x8b, 0x2e,
+  0x30, 0x09, 0xb1, 0x0e, 0x51, 0x36, 0x35, 0x06, 0x25, 0xae, 0x61, 0x1c, 0xa8, 0x36, 0xc1, 0x88,
+  0xf3, 0xda, 0x85, 0x5b, 0xe0, 0x50, 0x15, 0x7d, 0xef, 0xd1, 0x59, 0xb3, 0x8d, 0x9c, 0x51, 0x52,
+  0x44, 0xef, 0x38, 0x88, 0xb9, 0x60, 0xfb, 0xa4, 0xab, 0x35, 0xd2, 0x55, 0x98, 0x35, 0x2a, 0x4e,
+  0xf8, 0xda, 0xa1, 0x36, 0x6c, 0x1b, 0x05, 0xfc, 0x94, 0x67, 0xa9, 0x0c, 0x7f, 0x0c, 0xa6, 0xd3,
+  0x59, 0x34, 0xeb, 0x8f, 0x78, 0x38, 0xde, 0xeb, 0x62, 0x85, 0x29, 0xf5, 0x37, 0xf3, 0x2e, 0x8b,
+  0x21, 0x01, 0xce, 0x14, 0x7f, 0x9f, 0x25, 0x59, 0xc8, 0xff, 0x97, 0x28, 0x6b, 0xb6, 0x1f, 0x5e,
+  0xb2, 0xe5, 0xa7, 0x6c, 0xb8, 0xd8, 0x9d, 0x2f, 0xa6, 0x37, 0x3c, 0x20, 0x96, 0x09, 0xb9, 0x76,
+  0x5d, 0x2f, 0x8d, 0xd3, 0xfd, 0xd7, 0xef, 0x1a, 0xf8, 0x95, 0xd7, 0xc0, 0x1f, 0x71, 0x28, 0x7d,
+  0x1b, 0xfa, 0x2a, 0x64, 0xf7, 0xac, 0x9c, 0x8f, 0x29, 0x22, 0x43, 0xe9, 0xf5, 0xd1, 0x18, 0xa9,
+  0x83, 0xda, 0xde, 0x9f, 0xff, 0x95, 0x5e, 0x97, 0xc5, 0x9b, 0x8e, 0x38, 0x80, 0x04, 0x70, 0x63,
+  0x59, 0x68, 0x10, 0x6d, 0x34, 0x14, 0x7c, 0x6d, 0x1d, 0xb2, 0x34, 0x46, 0x86, 0x6d, 0x67, 0x76,
+  0x78, 0x8b, 0xc3, 0xb0, 0x61, 0x16, 0x59, 0x9f, 0x59, 0xd2, 0x9f, 0x50, 0xc8, 0x8a, 0xd6, 0xe6,
+  0x09, 0x27, 0x76, 0x25, 0x15, 0x72, 0xd0, 0x32, 0x34, 0xab, 0x06, 0xe7, 0xde, 0xdf, 0xa6, 0xd7,
+  0x1f, 0x02, 0x02, 0xfb, 0x48, 0x62, 0x11, 0xef, 0xda, 0xf3, 0x53, 0x48, 0xd3, 0xbc, 0xc4, 0x31,
+  0x19, 0x50, 0x0e, 0xd5, 0x69, 0x71, 0x19, 0xf7, 0x99, 0xe7, 0x8b, 0x5c, 0x0c, 0xb8, 0x35, 0xe7,
+  0xc8, 0x7f, 0x01, 0x95, 0xdd, 0xb0, 0x7c, 0xbe, 0xe8, 0x51, 0x52, 0x57, 0xe6, 0x02, 0x64, 0x96,
+  0xb3, 0xac, 0xbc, 0xe9, 0x21, 0x1b, 0x66, 0x35, 0x3a, 0xdf, 0xfe, 0x78, 0x90, 0xf3, 0x59, 0x9a,
+  0xf7, 0x7b, 0x04, 0xd3, 0xcb, 0xee, 0xfd, 0x74, 0x06, 0x12, 0xfc, 0xd3, 0xa2, 0x8b, 0x3d, 0xea,
+  0xfa, 0x3b, 0x5a, 0x49, 0xeb, 0x3c, 0xe1, 0xb5, 0x54, 0xe2, 0xee, 0x6c, 0x1e, 0x4c, 0x46, 0xc8,
+  0xdd, 0xa4, 0xc4, 0xc6, 0x1b, 0x9f, 0xc1, 0x26, 0xad, 0x36, 0xc6, 0xb5, 0x97, 0x4e, 0x28, 0xea,
+  0x8a, 0xf1, 0x70, 0x58, 0x13, 0x69, 0x8a, 0xbd, 0x55, 0xd9, 0x04, 0x8a, 0x1e, 0xbc, 0xa6, 0xfb,
+  0x04, 0x7d, 0x55, 0xf6, 0x09, 0xf6, 0x4c, 0xf5, 0x41, 0xec, 0xe1, 0x2f, 0xdd, 0x5f, 0x98, 0xbd,
+  0x41, 0xc5, 0x61, 0x23, 0xbe, 0x54, 0xc3, 0xdb, 0xe0, 0xc8, 0x50, 0x1c, 0x3f, 0x18, 0xba, 0x79,
+  0x39, 0x7d, 0xb6, 0x4f, 0x3c, 0x2b, 0x15, 0x8c, 0x5f, 0x85, 0xd3, 0xe9, 0x1a, 0x7a, 0x6d, 0x20,
+  0xc0, 0x83, 0x55, 0xac, 0x71, 0x40, 0x0f, 0x17, 0x93, 0x2f, 0x8e, 0x87, 0x2f, 0xf7, 0x46, 0x1b,
+  0xf2, 0x15, 0x96, 0x6b, 0xc5, 0x6c, 0x7c, 0x0f, 0x5a, 0x99, 0x18, 0x97, 0x18, 0x37, 0xf1, 0x1f,
+  0x46, 0x63, 0x03, 0x31, 0x17, 0xaf, 0x10, 0x12, 0xda, 0x70, 0xd4, 0xce, 0xc9, 0x4d, 0xde, 0x1f,
+  0x47, 0x90, 0x12, 0xf9, 0x3a, 0x3e, 0x5c, 0x89, 0xf6, 0x38, 0x0b, 0x06, 0x13, 0xc2, 0x24, 0x18,
+  0xf5, 0x77, 0x97, 0x4c, 0x71, 0x4a, 0x7c, 0x3c, 0xb9, 0x04, 0x40, 0x06, 0x9f, 0x4f, 0xac, 0xc0,
+  0xb0, 0x7f, 0xeb, 0x76, 0x62, 0x06, 0xcd, 0x5e, 0xc2, 0x27, 0xda, 0x78, 0x68, 0x27, 0xcd, 0x36,
+  0x48, 0xf6, 0x3b, 0x05, 0x54, 0x7a, 0x8c, 0xcf, 0xf7, 0xdf, 0x01, 0x07, 0x54, 0x5c, 0x18, 0xab,
+  0x09, 0x00, 0x00,
+};
+
+// app.js, 520 bytes minified, 280 bytes compressed
+#define __ASSET_APP_JS_TYPE "application/javascript"
+static const uint8_t __asset_app_js[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x75, 0x8f, 0xcd, 0x4e, 0xc3, 0x30,
+  0x10, 0x84, 0xef, 0x79, 0x8a, 0xed, 0xa5, 0x76, 0x04, 0xf8, 0x05, 0xaa, 0x1c, 0x00, 0x15, 0x09,
+  0x84, 0xe0, 0x10, 0x5e, 0xc0, 0xb1, 0x37, 0x95, 0x45, 0x70, 0x2a, 0x7b, 0x9d, 0x80, 0x68, 0xde,
+  0x9d, 0x75, 0x7f, 0x54, 0x0a, 0xed, 0xc9, 0xab, 0x19, 0xcd, 0xf8, 0x1b, 0xd9, 0x26, 0x6f, 0xc8,
+  0xf5, 0x1e, 0x64, 0x09, 0xdf, 0xc5, 0xa0, 0x03, 0xe0, 0x80, 0x9e, 0x22, 0x54, 0x60, 0x7b, 0x93,
+  0x3e, 0xf8, 0x56, 0x26, 0x85, 0xc0, 0x6f, 0x6d, 0x82, 0x5b, 0x13, 0xcc, 0xe7, 0x17, 0x1c, 0xb5,
+  0x42, 0xba, 0x25, 0x0a, 0xae, 0x49, 0x84, 0x52, 0x58, 0x4d, 0xfa, 0x66, 0x57, 0x26, 0xca, 0x45,
+  0xe1, 0x5a, 0x90, 0xb3, 0x7d, 0xf7, 0x66, 0x03, 0xb3, 0xd1, 0x79, 0xdb, 0x8f, 0x6a, 0x99, 0x95,
+  0xba, 0x4f, 0xc1, 0x60, 0x06, 0x08, 0x48, 0x29, 0xf8, 0x45, 0x31, 0x15, 0x1e, 0x47, 0xf8, 0x65,
+  0xca, 0x5d, 0xb4, 0x54, 0xda, 0xda, 0xad, 0xfc, 0xec, 0x22, 0xa1, 0xc7, 0x20, 0x45, 0x8b, 0x68,
+  0x1b, 0x6d, 0xde, 0xc5, 0x35, 0x1c, 0xd7, 0xe0, 0x61, 0x8e, 0xe5, 0x25, 0x4f, 0xf5, 0xeb, 0x8b,
+  0x5a, 0xeb, 0x10, 0xb9, 0x46, 0x65, 0x2e, 0xe6, 0xc9, 0xde, 0xc9, 0x4a, 0xa6, 0x5f, 0x76, 0x98,
+  0xcf, 0xbb, 0xaf, 0x47, 0xcb, 0xb5, 0x8d, 0x80, 0x2b, 0xb0, 0xca, 0xd9, 0x03, 0x7d, 0x3c, 0x25,
+  0xcc, 0x9a, 0x55, 0x83, 0xee, 0x12, 0x42, 0x55, 0x55, 0x40, 0x21, 0x6d, 0x7f, 0x8d, 0x8a, 0xf0,
+  0x93, 0xee, 0x7b, 0xcf, 0x7c, 0xc4, 0x3f, 0x88, 0x37, 0x36, 0x04, 0x27, 0x00, 0xbb, 0x88, 0xf0,
+  0x37, 0xd6, 0x6a, 0x56, 0xcf, 0xe6, 0x1e, 0xb2, 0x73, 0x39, 0xe8, 0x53, 0xd7, 0x9d, 0xcd, 0x79,
+  0xed, 0x8f, 0xa9, 0xff, 0xfe, 0xbe, 0x23, 0x4f, 0x98, 0x78, 0xda, 0x54, 0xca, 0x72, 0xf1, 0x03,
+  0x50, 0xa1, 0x02, 0xbd, 0x08, 0x02, 0x00, 0x00,
+};
+
+// monitor.js, 1151 bytes minified, 593 bytes compressed
+#define __ASSET_MONITOR_JS_TYPE "application/javascript"
+static const uint8_t __asset_monitor_js[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x53, 0xdb, 0x6e, 0x1a, 0x31,
+  0x10, 0x7d, 0xe7, 0x2b, 0x9c, 0x97, 0xd8, 0xb4, 0xc4, 0x5a, 0x22, 0xa5, 0x0f, 0x45, 0x24, 0x4a,
+  0x23, 0xd4, 0x8b, 0xda, 0x54, 0x02, 0xa4, 0x56, 0x8a, 0xf2, 0xe0, 0xec, 0x0e, 0xb0, 0xd2, 0x62,
+  0x6f, 0xec, 0xd9, 0x2e, 0xa8, 0x41, 0xea, 0xd7, 0xf4, 0xc3, 0xfa, 0x25, 0x9d, 0xf1, 0xb2, 0x34,
+  0x80, 0xaa, 0x08, 0x01, 0xf6, 0x9c, 0x99, 0xe3, 0x99, 0xe3, 0x63, 0x35, 0xab, 0x6c, 0x8a, 0xb9,
+  0xb3, 0x42, 0x75, 0xc5, 0xcf, 0xce, 0x0f, 0xe3, 0x85, 0x29, 0x73, 0x31, 0x14, 0x99, 0x4b, 0xab,
+  0x25, 0x58, 0xd4, 0x69, 0xe5, 0x3d, 0xfd, 0x4f, 0x52, 0x9f, 0x97, 0x28, 0x4e, 0x4f, 0xff, 0x83,
+  0xe8, 0x39, 0xe0, 0x35, 0xa2, 0xcf, 0x1f, 0x2a, 0x04, 0x25, 0x33, 0x83, 0xe6, 0x8c, 0x98, 0x64,
+  0x77, 0x10, 0x49, 0x1f, 0x5c, 0xb6, 0x7e, 0xce, 0x4a, 0xd9, 0xa3, 0x02, 0x78, 0xf9, 0x6e, 0xfd,
+  0x31, 0x53, 0x12, 0xa1, 0x80, 0xb9, 0x37, 0xcb, 0xd0, 0x16, 0xe0, 0xba, 0x84, 0x40, 0x15, 0x77,
+  0x72, 0x0c, 0x26, 0x93, 0x3d, 0x21, 0xaf, 0x6d, 0xa8, 0xc1, 0xf3, 0xea, 0x9b, 0xcf, 0x11, 0xe4,
+  0x7d, 0x93, 0x68, 0x61, 0x85, 0x94, 0x97, 0x34, 0xbb, 0xa5, 0x59, 0x8d, 0x5d, 0xcd, 0x85, 0xe7,
+  0x09, 0x85, 0xf2, 0x99, 0x50, 0x27, 0x3c, 0xd0, 0xd3, 0x93, 0x38, 0xe1, 0x1e, 0x78, 0x48, 0x0f,
+  0x58, 0x79, 0x3b, 0xe8, 0x6c, 0x3a, 0xbb, 0xe1, 0x53, 0x28, 0x0a, 0xe5, 0x5d, 0xdd, 0x13, 0x48,
+  0x74, 0x31, 0xc9, 0xd5, 0x3a, 0xb7, 0x01, 0x3c, 0xde, 0x30, 0x76, 0xd6, 0xef, 0x6a, 0x86, 0x6e,
+  0x9c, 0x45, 0x6a, 0x9a, 0xf8, 0x79, 0xb7, 0xc7, 0x61, 0x1d, 0x0d, 0xde, 0x96, 0x73, 0x2f, 0x44,
+  0x41, 0x79, 0x7c, 0xea, 0x96, 0x89, 0x3a, 0x53, 0xc9, 0x76, 0xbe, 0x94, 0xa0, 0xe3, 0x33, 0x06,
+  0x9d, 0x54, 0xa7, 0xae, 0x98, 0x94, 0xc6, 0x12, 0x7e, 0x11, 0xb7, 0x85, 0x09, 0xe1, 0xd6, 0x2c,
+  0x81, 0x02, 0x92, 0xcf, 0x90, 0x1c, 0x7d, 0xa1, 0x97, 0xd2, 0x11, 0xdf, 0xae, 0x0f, 0x78, 0xa4,
+  0x1c, 0x0b, 0xb5, 0xf8, 0xfe, 0xe5, 0xf3, 0x07, 0xc4, 0x72, 0x0c, 0x8f, 0x15, 0x04, 0x54, 0x74,
+  0x1c, 0x61, 0xda, 0xd9, 0xc2, 0x99, 0x8c, 0x52, 0xf6, 0xbd, 0xc0, 0xda, 0x31, 0x1c, 0xd0, 0x60,
+  0x45, 0x8a, 0x0e, 0xa3, 0xa6, 0x2d, 0x29, 0xe7, 0x7f, 0x9a, 0x7c, 0xbd, 0xd5, 0xa5, 0xf1, 0x01,
+  0x62, 0xa2, 0x87, 0x50, 0x3a, 0x1a, 0x67, 0xca, 0x1a, 0x34, 0xda, 0x67, 0xba, 0x70, 0x01, 0xc5,
+  0xa5, 0x48, 0xd8, 0x39, 0xf1, 0xaa, 0x68, 0xcd, 0x1c, 0x51, 0xad, 0x2d, 0xfc, 0x5a, 0x48, 0xb1,
+  0x33, 0x00, 0xeb, 0x28, 0xc2, 0xc2, 0xd5, 0x96, 0xad, 0xb0, 0xe9, 0x64, 0x7a, 0x07, 0xe9, 0x99,
+  0xf3, 0x23, 0x93, 0x2e, 0xd4, 0xbf, 0x46, 0x5f, 0x16, 0xfb, 0xd9, 0xd5, 0x6a, 0xcc, 0x97, 0x70,
+  0x10, 0x0a, 0xae, 0xf2, 0xe9, 0x61, 0x30, 0x23, 0x75, 0x72, 0x6b, 0xf8, 0x88, 0x7d, 0x84, 0x4d,
+  0x79, 0x47, 0xce, 0xc7, 0x7b, 0x76, 0x94, 0x92, 0xc9, 0x4a, 0x52, 0xf7, 0x1c, 0xd0, 0xe8, 0x26,
+  0xe4, 0x7e, 0x3b, 0x57, 0xfd, 0x37, 0xdd, 0xee, 0x21, 0x1f, 0xbd, 0x06, 0xca, 0x53, 0xa8, 0x0b,
+  0xb0, 0x73, 0x5c, 0x88, 0x57, 0xe2, 0x9c, 0x84, 0x68, 0x80, 0x36, 0x76, 0x25, 0xe4, 0x9f, 0x5f,
+  0xbf, 0xa5, 0x78, 0x2b, 0xa4, 0x64, 0x82, 0x0d, 0x7d, 0xb7, 0xe6, 0xce, 0xb4, 0x8d, 0x37, 0x5c,
+  0x2f, 0xf2, 0x02, 0x84, 0x8a, 0x53, 0x12, 0x75, 0x68, 0x4b, 0x2f, 0x5b, 0xdf, 0xb3, 0x1a, 0x11,
+  0xcd, 0x48, 0x33, 0x04, 0xd6, 0x20, 0xba, 0x6a, 0x43, 0x9f, 0x00, 0x38, 0xa5, 0xf9, 0x5d, 0x85,
+  0x8a, 0xed, 0xd1, 0x13, 0xfd, 0x24, 0x61, 0x81, 0x36, 0xad, 0x0b, 0xc0, 0x7b, 0xe7, 0x8f, 0x6c,
+  0x70, 0x54, 0x76, 0xb1, 0x5f, 0x56, 0x82, 0x55, 0xf2, 0xfd, 0x68, 0x4a, 0x0f, 0x93, 0x1f, 0x1a,
+  0xdd, 0xe5, 0x55, 0xc8, 0x6d, 0x0a, 0x43, 0x56, 0xc6, 0x36, 0x56, 0x88, 0x36, 0x02, 0x9b, 0xa9,
+  0xd8, 0x4a, 0x63, 0x4e, 0x1e, 0x90, 0x7e, 0xff, 0x02, 0x90, 0x01, 0xd0, 0x7a, 0x81, 0x04, 0x00,
+  0x00,
+};
+
+#endif
@@ -13,6 +13,8 @@
 void ESPKNXIP::physical_address_set(address_t const &addr)
 {
   physaddr = addr;
+  eeprom_dirty |= EEPROM_DIRTY_PHYSADDR;
+  state_version++;
 }
 
 address_t ESPKNXIP::physical_address_get()
@@ -23,17 +25,38 @@ address_t ESPKNXIP::physical_address_get()
 /**
  * Configuration functions start here
  */
-config_id_t ESPKNXIP::config_register_string(String name, uint8_t len, String _default, enable_condition_t cond)
+
+uint16_t ESPKNXIP::__config_space_used()
+{
+  if (registered_configs == 0)
+    return 0;
+
+  return custom_configs[registered_configs - 1].offset + custom_configs[registered_configs - 1].len;
+}
+
+/**
+ * Makes room for one more config with len bytes of data
+ */
+bool ESPKNXIP::__config_reserve(uint16_t len)
 {
-  if (registered_configs >= MAX_CONFIGS)
+  return __registry_reserve((void **)&custom_configs, custom_configs_capacity, registered_configs + 1, sizeof(config_t), MAX_CONFIGS) &&
+         __registry_reserve((void **)&custom_config_data, custom_config_data_capacity, __config_space_used() + len, sizeof(uint8_t), MAX_CONFIG_SPACE);
+}
+
+config_id_t ESPKNXIP::config_register_string(const __FlashStringHelper *name, uint8_t len, const __FlashStringHelper *_default, enable_condition_t cond)
+{
+  if (!__config_reserve(sizeof(uint8_t) + len))
     return -1;
 
-  if (_default.length() >= len)
+  if (strlen_P((PGM_P)_default) >= len)
     return -1;
 
   config_id_t id = registered_configs;
 
-  custom_configs[id].name = name;
+  custom_configs[id].name = __string_pool_add(name);
+  if (custom_configs[id].name == (string_ref_t)-1)
+    return -1;
+  custom_configs[id].key = __name_hash(name);
   custom_configs[id].type = CONFIG_TYPE_STRING;
   custom_configs[id].len = sizeof(uint8_t) + len;
   custom_configs[id].cond = cond;
@@ -42,7 +65,10 @@ config_id_t ESPKNXIP::config_register_string(String name, uint8_t len, String _d
   else
     custom_configs[id].offset = custom_configs[id - 1].offset + custom_configs[id - 1].len;
 
-  __config_set_string(id, _default);
+  custom_configs[id].default_value.str = __string_pool_add(_default);
+  if (custom_configs[id].default_value.str == (string_ref_t)-1)
+    return -1;
+  __config_set_default(id);
 
   registered_configs++;
 
@@ -59,14 +85,17 @@ config_id_t ESPKNXIP::config_register_string(String name, uint8_t len, String _d
   return id;
 }
 
-config_id_t ESPKNXIP::config_register_int(String name, int32_t _default, enable_condition_t cond)
+config_id_t ESPKNXIP::config_register_int(const __FlashStringHelper *name, int32_t _default, enable_condition_t cond)
 {
-  if (registered_configs >= MAX_CONFIGS)
+  if (!__config_reserve(sizeof(uint8_t) + sizeof(int32_t)))
     return -1;
 
   config_id_t id = registered_configs;
 
-  custom_configs[id].name = name;
+  custom_configs[id].name = __string_pool_add(name);
+  if (custom_configs[id].name == (string_ref_t)-1)
+    return -1;
+  custom_configs[id].key = __name_hash(name);
   custom_configs[id].type = CONFIG_TYPE_INT;
   custom_configs[id].len = sizeof(uint8_t) + sizeof(int32_t);
   custom_configs[id].cond = cond;
@@ -75,7 +104,8 @@ config_id_t ESPKNXIP::config_register_int(String name, int32_t _default, enable_
   else
     custom_configs[id].offset = custom_configs[id - 1].offset + custom_configs[id - 1].len;
 
-  __config_set_int(id, _default);
+  custom_configs[id].default_value.i = _default;
+  __config_set_default(id);
 
   registered_configs++;
 
@@ -92,14 +122,17 @@ config_id_t ESPKNXIP::config_register_int(String name, int32_t _default, enable_
   return id;
 }
 
-config_id_t ESPKNXIP::config_register_bool(String name, bool _default, enable_condition_t cond)
+config_id_t ESPKNXIP::config_register_bool(const __FlashStringHelper *name, bool _default, enable_condition_t cond)
 {
-  if (registered_configs >= MAX_CONFIGS)
+  if (!__config_reserve(sizeof(uint8_t) + sizeof(uint8_t)))
     return -1;
 
   config_id_t id = registered_configs;
 
-  custom_configs[id].name = name;
+  custom_configs[id].name = __string_pool_add(name);
+  if (custom_configs[id].name == (string_ref_t)-1)
+    return -1;
+  custom_configs[id].key = __name_hash(name);
   custom_configs[id].type = CONFIG_TYPE_BOOL;
   custom_configs[id].len = sizeof(uint8_t) + sizeof(uint8_t);
   custom_configs[id].cond = cond;
@@ -108,7 +141,8 @@ config_id_t ESPKNXIP::config_register_bool(String name, bool _default, enable_co
   else
     custom_configs[id].offset = custom_configs[id - 1].offset + custom_configs[id - 1].len;
 
-  __config_set_bool(id, _default);
+  custom_configs[id].default_value.b = _default;
+  __config_set_default(id);
 
   registered_configs++;
 
@@ -125,9 +159,9 @@ config_id_t ESPKNXIP::config_register_bool(String name, bool _default, enable_co
   return id;
 }
 
-config_id_t ESPKNXIP::config_register_options(String name, option_entry_t *options, uint8_t _default, enable_condition_t cond)
+config_id_t ESPKNXIP::config_register_options(const __FlashStringHelper *name, option_entry_t *options, uint8_t _default, enable_condition_t cond)
 {
-  if (registered_configs >= MAX_CONFIGS)
+  if (!__config_reserve(sizeof(uint8_t) + sizeof(uint8_t)))
     return -1;
 
   if (options == nullptr || options->name == nullptr)
@@ -135,7 +169,10 @@ config_id_t ESPKNXIP::config_register_options(String name, option_entry_t *optio
 
   config_id_t id = registered_configs;
 
-  custom_configs[id].name = name;
+  custom_configs[id].name = __string_pool_add(name);
+  if (custom_configs[id].name == (string_ref_t)-1)
+    return -1;
+  custom_configs[id].key = __name_hash(name);
   custom_configs[id].type = CONFIG_TYPE_OPTIONS;
   custom_configs[id].len = sizeof(uint8_t) + sizeof(uint8_t);
   custom_configs[id].cond = cond;
@@ -146,7 +183,8 @@ config_id_t ESPKNXIP::config_register_options(String name, option_entry_t *optio
 
   custom_configs[id].data.options = options;
 
-  __config_set_options(id, _default);
+  custom_configs[id].default_value.option = _default;
+  __config_set_default(id);
 
   registered_configs++;
 
@@ -163,14 +201,17 @@ config_id_t ESPKNXIP::config_register_options(String name, option_entry_t *optio
   return id;
 }
 
-config_id_t ESPKNXIP::config_register_ga(String name, enable_condition_t cond)
+config_id_t ESPKNXIP::config_register_ga(const __FlashStringHelper *name, enable_condition_t cond)
 {
-  if (registered_configs >= MAX_CONFIGS)
+  if (!__config_reserve(sizeof(uint8_t) + sizeof(address_t)))
     return -1;
 
   config_id_t id = registered_configs;
 
-  custom_configs[id].name = name;
+  custom_configs[id].name = __string_pool_add(name);
+  if (custom_configs[id].name == (string_ref_t)-1)
+    return -1;
+  custom_configs[id].key = __name_hash(name);
   custom_configs[id].type = CONFIG_TYPE_GA;
   custom_configs[id].len = sizeof(uint8_t) + sizeof(address_t);
   custom_configs[id].cond = cond;
@@ -179,9 +220,8 @@ config_id_t ESPKNXIP::config_register_ga(String name, enable_condition_t cond)
   else
     custom_configs[id].offset = custom_configs[id - 1].offset + custom_configs[id - 1].len;
 
-  address_t t;
-  t.value = 0;
-  __config_set_ga(id, t);
+  custom_configs[id].default_value.ga.value = 0;
+  __config_set_default(id);
 
   registered_configs++;
 
@@ -198,6 +238,246 @@ config_id_t ESPKNXIP::config_register_ga(String name, enable_condition_t cond)
   return id;
 }
 
+config_id_t ESPKNXIP::config_register_string(String name, uint8_t len, String _default, enable_condition_t cond)
+{
+  if (_default.length() >= len)
+    return -1;
+  // Both are added first, so the pointers stay valid
+  string_ref_t name_ref = __string_pool_add(name);
+  string_ref_t default_ref = __string_pool_add(_default);
+  if (name_ref == (string_ref_t)-1 || default_ref == (string_ref_t)-1)
+    return -1;
+  return config_register_string(__string_pool_get(name_ref), len, __string_pool_get(default_ref), cond);
+}
+
+config_id_t ESPKNXIP::config_register_int(String name, int32_t _default, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return config_register_int(__string_pool_get(ref), _default, cond);
+}
+
+config_id_t ESPKNXIP::config_register_bool(String name, bool _default, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return config_register_bool(__string_pool_get(ref), _default, cond);
+}
+
+config_id_t ESPKNXIP::config_register_options(String name, option_entry_t *options, uint8_t _default, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return config_register_options(__string_pool_get(ref), options, _default, cond);
+}
+
+config_id_t ESPKNXIP::config_register_ga(String name, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return config_register_ga(__string_pool_get(ref), cond);
+}
+
+void ESPKNXIP::__config_set_default(config_id_t id)
+{
+  custom_config_data[custom_configs[id].offset] = CONFIG_FLAGS_NO_FLAGS;
+  switch (custom_configs[id].type)
+  {
+    case CONFIG_TYPE_STRING:
+    {
+      String val(__string_pool_get(custom_configs[id].default_value.str));
+      __config_set_string(id, val);
+      break;
+    }
+    case CONFIG_TYPE_INT:
+      __config_set_int(id, custom_configs[id].default_value.i);
+      break;
+    case CONFIG_TYPE_BOOL:
+      __config_set_bool(id, custom_configs[id].default_value.b);
+      break;
+    case CONFIG_TYPE_OPTIONS:
+      __config_set_options(id, custom_configs[id].default_value.option);
+      break;
+    case CONFIG_TYPE_GA:
+      __config_set_ga(id, custom_configs[id].default_value.ga);
+      break;
+  }
+}
+
+/**
+ * Restores a stored config value. Unset values keep the registered default.
+ * Returns false if the stored value does not fit the config. With dry_run, only the check is done.
+ */
+bool ESPKNXIP::__config_restore(config_id_t id, uint8_t len, uint8_t const *data, bool dry_run)
+{
+  config_t &config = custom_configs[id];
+  // The length of a string config may change between firmware versions, all other types have a fixed length
+  if (len < 1 || (len != config.len && config.type != CONFIG_TYPE_STRING))
+    return false;
+  if (dry_run)
+    return true;
+
+  config_flags_t flags = (config_flags_t)data[0];
+  if (!(flags & CONFIG_FLAGS_VALUE_SET))
+  {
+    __config_set_default(id);
+    return true;
+  }
+
+  char old_str[config.len];
+  config_value_t old_value = __config_value_save(id, old_str);
+  custom_config_data[config.offset] = flags;
+  config.dirty = true;
+  uint8_t value_len = (len < config.len ? len : config.len) - sizeof(uint8_t);
+  memcpy(&custom_config_data[config.offset + sizeof(uint8_t)], data + sizeof(uint8_t), value_len);
+  if (config.type == CONFIG_TYPE_STRING)
+    custom_config_data[config.offset + config.len - 1] = 0;
+  __config_decode(id);
+  __config_notify(id, old_value);
+  return true;
+}
+
+/**
+ * Writes len bytes at offset of the stored config (flags byte included), e.g. for a memory write over the bus
+ */
+void ESPKNXIP::__config_write(config_id_t id, uint8_t offset, uint8_t len, uint8_t const *data)
+{
+  config_t &config = custom_configs[id];
+  char old_str[config.len];
+  config_value_t old_value = __config_value_save(id, old_str);
+  memcpy(&custom_config_data[config.offset + offset], data, len);
+  config.dirty = true;
+  // Make sure strings stay terminated, no matter what was written
+  if (config.type == CONFIG_TYPE_STRING)
+    custom_config_data[config.offset + config.len - 1] = 0;
+  __config_decode(id);
+  __config_notify(id, old_value);
+}
+
+/**
+ * Returns the config whose stored data contains offset, or -1
+ */
+config_id_t ESPKNXIP::__config_find_offset(uint16_t offset)
+{
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    if (offset >= custom_configs[i].offset && offset < custom_configs[i].offset + custom_configs[i].len)
+      return i;
+  }
+  return -1;
+}
+
+/**
+ * Updates the decoded value after custom_config_data was written directly
+ */
+void ESPKNXIP::__config_decode(config_id_t id)
+{
+  config_t &config = custom_configs[id];
+  uint8_t *data = &custom_config_data[config.offset + sizeof(uint8_t)];
+  switch (config.type)
+  {
+    case CONFIG_TYPE_INT:
+      config.value.i = (data[0] << 24) + (data[1] << 16) + (data[2] << 8) + (data[3] << 0);
+      break;
+    case CONFIG_TYPE_BOOL:
+      config.value.b = data[0] != 0;
+      break;
+    case CONFIG_TYPE_OPTIONS:
+      config.value.option = data[0];
+      break;
+    case CONFIG_TYPE_GA:
+      config.value.ga.bytes.high = data[0];
+      config.value.ga.bytes.low = data[1];
+      break;
+    default:
+      // Strings are read from custom_config_data directly
+      break;
+  }
+}
+
+/**
+ * Change notifications
+ * A subscribed function is called after a set, restore, import or memory write changed the value of its config.
+ * Writing the same value again does not call it.
+ */
+
+void ESPKNXIP::config_subscribe(config_id_t id, config_changed_fptr_t fkt, void *arg)
+{
+  if (id >= registered_configs)
+    return;
+
+  custom_configs[id].on_change = fkt;
+  custom_configs[id].on_change_arg = arg;
+}
+
+/**
+ * Returns the current value as old value for __config_notify(). Strings are copied to str, which must hold len bytes.
+ */
+config_value_t ESPKNXIP::__config_value_save(config_id_t id, char *str)
+{
+  config_value_t val = custom_configs[id].value;
+  if (custom_configs[id].type == CONFIG_TYPE_STRING)
+  {
+    // Without a subscriber, the copy is never read
+    if (custom_configs[id].on_change != nullptr)
+      memcpy(str, config_get_string_view(id), custom_configs[id].len - sizeof(uint8_t));
+    val.str = str;
+  }
+  return val;
+}
+
+/**
+ * Called after every write of a config value, calls the subscriber if the value changed
+ */
+void ESPKNXIP::__config_notify(config_id_t id, config_value_t const &old_value)
+{
+  state_version++;
+  config_t &config = custom_configs[id];
+  if (config.on_change == nullptr)
+    return;
+
+  config_value_t new_value = config.value;
+  bool changed = false;
+  switch (config.type)
+  {
+    case CONFIG_TYPE_STRING:
+      new_value.str = config_get_string_view(id);
+      changed = strcmp(old_value.str, new_value.str) != 0;
+      break;
+    case CONFIG_TYPE_INT:
+      changed = old_value.i != new_value.i;
+      break;
+    case CONFIG_TYPE_BOOL:
+      changed = old_value.b != new_value.b;
+      break;
+    case CONFIG_TYPE_OPTIONS:
+      changed = old_value.option != new_value.option;
+      break;
+    case CONFIG_TYPE_GA:
+      changed = old_value.ga.value != new_value.ga.value;
+      break;
+    default:
+      break;
+  }
+  if (changed)
+    config.on_change(id, old_value, new_value, config.on_change_arg);
+}
+
+void ESPKNXIP::config_set_sync(config_id_t id, callback_id_t cb)
+{
+  if (id >= registered_configs || cb >= registered_callbacks)
+    return;
+  if (custom_configs[id].type != CONFIG_TYPE_GA)
+    return;
+
+  custom_configs[id].sync = true;
+  custom_configs[id].sync_callback = cb;
+}
+
 void ESPKNXIP::__config_set_flags(config_id_t id, config_flags_t flags)
 {
   DEBUG_PRINT("Setting flag @ ");
@@ -207,6 +487,7 @@ void ESPKNXIP::__config_set_flags(config_id_t id, config_flags_t flags)
   DEBUG_PRINT(" | ");
   DEBUG_PRINT(flags, BIN);
   custom_config_data[custom_configs[id].offset] |= (uint8_t)flags;
+  custom_configs[id].dirty = true;
   DEBUG_PRINT(" = ");
   DEBUG_PRINTLN(custom_config_data[custom_configs[id].offset], BIN);
 }
@@ -217,7 +498,8 @@ void ESPKNXIP::config_set_string(config_id_t id, String val)
     return;
   if (custom_configs[id].type != CONFIG_TYPE_STRING)
     return;
-  if (val.length() >= custom_configs[id].len)
+  // len includes the flags byte, the value needs room for the \0
+  if (val.length() >= custom_configs[id].len - sizeof(uint8_t))
     return;
   __config_set_flags(id, CONFIG_FLAGS_VALUE_SET);
   __config_set_string(id, val);
@@ -225,7 +507,11 @@ void ESPKNXIP::config_set_string(config_id_t id, String val)
 
 void ESPKNXIP::__config_set_string(config_id_t id, String &val)
 {
+  char old_str[custom_configs[id].len];
+  config_value_t old_value = __config_value_save(id, old_str);
+  custom_configs[id].dirty = true;
   memcpy(&custom_config_data[custom_configs[id].offset + sizeof(uint8_t)], val.c_str(), val.length()+1);
+  __config_notify(id, old_value);
 }
 
 void ESPKNXIP::config_set_int(config_id_t id, int32_t val)
@@ -240,6 +526,8 @@ void ESPKNXIP::config_set_int(config_id_t id, int32_t val)
 
 void ESPKNXIP::__config_set_int(config_id_t id, int32_t val)
 {
+  config_value_t old_value = custom_configs[id].value;
+  custom_configs[id].dirty = true;
   // This does not work for some reason:
   // Could be due to pointer alignment
   //int32_t *v = (int32_t *)(custom_config_data + custom_configs[id].offset);
@@ -248,6 +536,8 @@ void ESPKNXIP::__config_set_int(config_id_t id, int32_t val)
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 1] = (uint8_t)((val & 0x00FF0000) >> 16);
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 2] = (uint8_t)((val & 0x0000FF00) >>  8);
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 3] = (uint8_t)((val & 0x000000FF) >>  0);
+  custom_configs[id].value.i = val;
+  __config_notify(id, old_value);
 }
 
 void ESPKNXIP::config_set_bool(config_id_t id, bool val)
@@ -262,7 +552,11 @@ void ESPKNXIP::config_set_bool(config_id_t id, bool val)
 
 void ESPKNXIP::__config_set_bool(config_id_t id, bool val)
 {
+  config_value_t old_value = custom_configs[id].value;
+  custom_configs[id].dirty = true;
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t)] = val ? 1 : 0;
+  custom_configs[id].value.b = val;
+  __config_notify(id, old_value);
 }
 
 void ESPKNXIP::config_set_options(config_id_t id, uint8_t val)
@@ -287,7 +581,11 @@ void ESPKNXIP::config_set_options(config_id_t id, uint8_t val)
 
 void ESPKNXIP::__config_set_options(config_id_t id, uint8_t val)
 {
+  config_value_t old_value = custom_configs[id].value;
+  custom_configs[id].dirty = true;
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t)] = val;
+  custom_configs[id].value.option = val;
+  __config_notify(id, old_value);
 }
 
 void ESPKNXIP::config_set_ga(config_id_t id, address_t const &val)
@@ -302,8 +600,12 @@ void ESPKNXIP::config_set_ga(config_id_t id, address_t const &val)
 
 void ESPKNXIP::__config_set_ga(config_id_t id, address_t const &val)
 {
+  config_value_t old_value = custom_configs[id].value;
+  custom_configs[id].dirty = true;
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 0] = val.bytes.high;
   custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 1] = val.bytes.low;
+  custom_configs[id].value.ga = val;
+  __config_notify(id, old_value);
 }
 
 String ESPKNXIP::config_get_string(config_id_t id)
@@ -311,7 +613,15 @@ String ESPKNXIP::config_get_string(config_id_t id)
   if (id >= registered_configs)
     return String("");
 
-  return String((char *)&custom_config_data[custom_configs[id].offset + sizeof(uint8_t)]);
+  return String(config_get_string_view(id));
+}
+
+const char *ESPKNXIP::config_get_string_view(config_id_t id)
+{
+  if (id >= registered_configs)
+    return "";
+
+  return (const char *)&custom_config_data[custom_configs[id].offset + sizeof(uint8_t)];
 }
 
 int32_t ESPKNXIP::config_get_int(config_id_t id)
@@ -319,11 +629,7 @@ int32_t ESPKNXIP::config_get_int(config_id_t id)
   if (id >= registered_configs)
     return 0;
 
-  int32_t v = (custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 0] << 24) +
-              (custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 1] << 16) +
-              (custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 2] <<  8) +
-              (custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 3] <<  0);
-  return v;
+  return custom_configs[id].value.i;
 }
 
 bool ESPKNXIP::config_get_bool(config_id_t id)
@@ -331,7 +637,7 @@ bool ESPKNXIP::config_get_bool(config_id_t id)
   if (id >= registered_configs)
     return false;
 
-  return custom_config_data[custom_configs[id].offset + sizeof(uint8_t)] != 0;
+  return custom_configs[id].value.b;
 }
 
 uint8_t ESPKNXIP::config_get_options(config_id_t id)
@@ -339,20 +645,17 @@ uint8_t ESPKNXIP::config_get_options(config_id_t id)
   if (id >= registered_configs)
     return false;
 
-  return custom_config_data[custom_configs[id].offset + sizeof(uint8_t)];
+  return custom_configs[id].value.option;
 }
 
 address_t ESPKNXIP::config_get_ga(config_id_t id)
 {
-  address_t t;
   if (id >= registered_configs)
   {
+    address_t t;
     t.value = 0;
     return t;
   }
 
-  t.bytes.high = custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 0];
-  t.bytes.low = custom_config_data[custom_configs[id].offset + sizeof(uint8_t) + 1];
-
-  return t;
+  return custom_configs[id].value.ga;
 }
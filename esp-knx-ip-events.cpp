@@ -0,0 +1,230 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+#if !DISABLE_EVENTS
+
+/**
+ * Event functions
+ * Clients connect to __EVENTS_PATH and keep the connection open (Server-Sent Events). Every EVENT_INTERVAL ms,
+ * changed feedback values are sent as "feedback" events. With ?telegrams=1, received group telegrams are sent as
+ * "telegram" events as they arrive, optionally filtered with ?ga=area[/line[/member]]. Callbacks exceeding
+ * SLOW_CALLBACK_THRESHOLD are reported to all clients as "slow_callback" events.
+ * Nothing ever waits for a client: if its send buffer is full, the event is skipped.
+ */
+
+void ESPKNXIP::__handle_events()
+{
+  DEBUG_PRINTLN(F("Events called"));
+  event_client_t *c = nullptr;
+  for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; ++i)
+  {
+    if (!event_clients[i].client.connected())
+    {
+      c = &event_clients[i];
+      break;
+    }
+  }
+  if (c == nullptr)
+  {
+    server->send(503, F("text/plain"), F("Too many event clients"));
+    return;
+  }
+
+  c->telegrams = server->hasArg(F("telegrams"));
+  if (!__address_filter_parse(server->arg(F("ga")), c->filter, true))
+  {
+    server->send(400, F("text/plain"), F("Invalid group address filter"));
+    return;
+  }
+  c->resync = true;
+  c->dropped = 0;
+  c->last_send = millis();
+
+  // The response never ends, so the webserver is bypassed and the connection is kept here
+  c->client.stop();
+  c->client = server->client();
+  c->client.setNoDelay(true);
+  c->client.print(F("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n"));
+}
+
+void ESPKNXIP::__loop_events()
+{
+  unsigned long now = millis();
+  if ((long)(now - event_next_tick) < 0)
+    return;
+  event_next_tick = now + EVENT_INTERVAL;
+
+  bool connected = false;
+  for (uint8_t i = 0; i < MAX_EVENT_CLIENTS; ++i)
+  {
+    if (event_clients[i].client.connected())
+      connected = true;
+    else
+      event_clients[i].client.stop();
+  }
+  if (!connected)
+    return;
+
+  // Registration is done once clients can connect
+  if (event_snapshot == nullptr && registered_feedbacks > 0)
+  {
+    event_snapshot = (uint32_t *)calloc(registered_feedbacks, sizeof(uint32_t));
+    if (event_snapshot == nullptr)
+      return;
+  }
+
+  // Values are compared once per tick, so a value changing faster than that is sent once per tick
+  uint8_t changed[registered_feedbacks / 8 + 1];
+  memset(changed, 0, sizeof(changed));
+  for (feedback_id_t i = 0; i < registered_feedbacks; ++i)
+  {
+    uint32_t val = 0;
+    switch (feedbacks[i].type)
+    {
+      case FEEDBACK_TYPE_INT: memcpy(&val, feedbacks[i].data, sizeof(int32_t)); break;
+      case FEEDBACK_TYPE_FLOAT: memcpy(&val, feedbacks[i].data, sizeof(float)); break;
+      case FEEDBACK_TYPE_BOOL: val = *(bool *)feedbacks[i].data; break;
+      default: continue;
+    }
+    if (val != event_snapshot[i])
+    {
+      event_snapshot[i] = val;
+      changed[i / 8] |= 1 << (i % 8);
+    }
+  }
+
+  for (uint8_t c = 0; c < MAX_EVENT_CLIENTS; ++c)
+  {
+    event_client_t &client = event_clients[c];
+    if (!client.client.connected())
+      continue;
+
+    // Events are collected, so a tick is a single write per client
+    char buf[256];
+    uint16_t len = 0;
+    bool ok = true;
+    for (feedback_id_t i = 0; ok && i < registered_feedbacks; ++i)
+    {
+      if (!client.resync && !(changed[i / 8] & (1 << (i % 8))))
+        continue;
+      if (feedbacks[i].type == FEEDBACK_TYPE_ACTION || (feedbacks[i].cond && !feedbacks[i].cond()))
+        continue;
+      char ev[80];
+      uint8_t n = __event_format_feedback(i, ev, sizeof(ev));
+      if (len + n > sizeof(buf))
+      {
+        ok = __event_send(client, buf, len);
+        len = 0;
+      }
+      memcpy(buf + len, ev, n);
+      len += n;
+    }
+    if (ok && len > 0)
+      ok = __event_send(client, buf, len);
+
+    if (ok && client.dropped > 0)
+    {
+      len = snprintf_P(buf, sizeof(buf), PSTR("event: dropped\ndata: %u\n\n"), client.dropped);
+      if (__event_send(client, buf, len))
+        client.dropped = 0;
+    }
+
+    // A comment now and then lets both sides notice a dead connection
+    if (ok && now - client.last_send >= 15000)
+      __event_send(client, ":\n\n", 3);
+
+    // A client that missed values gets all of them once it has room again
+    client.resync = !ok;
+  }
+}
+
+uint8_t ESPKNXIP::__event_format_feedback(feedback_id_t id, char *buf, uint8_t size)
+{
+  char val[33];
+  switch (feedbacks[id].type)
+  {
+    case FEEDBACK_TYPE_INT:
+      snprintf_P(val, sizeof(val), PSTR("%d"), *(int32_t *)feedbacks[id].data);
+      break;
+    case FEEDBACK_TYPE_FLOAT:
+    {
+      float f = *(float *)feedbacks[id].data;
+      if (isnan(f) || isinf(f))
+        strcpy_P(val, PSTR("null"));
+      else
+        dtostrf(f, 1, feedbacks[id].options.float_options.precision, val);
+      break;
+    }
+    case FEEDBACK_TYPE_BOOL:
+      strcpy_P(val, (*(bool *)feedbacks[id].data) ? PSTR("true") : PSTR("false"));
+      break;
+    default:
+      val[0] = 0;
+      break;
+  }
+  int len = snprintf_P(buf, size, PSTR("event: feedback\ndata: {\"id\":%u,\"value\":%s}\n\n"), id, val);
+  return len < size ? len : size - 1;
+}
+
+void ESPKNXIP::__event_telegram(cemi_service_t *cemi_data, knx_command_type_t ct, uint8_t data_len, uint8_t *data)
+{
+  char buf[128];
+  int len = -1;
+  for (uint8_t c = 0; c < MAX_EVENT_CLIENTS; ++c)
+  {
+    event_client_t &client = event_clients[c];
+    if (!client.telegrams || !client.client.connected())
+      continue;
+
+    address_t &dst = cemi_data->destination;
+    if (!__address_filter_match(client.filter, dst))
+      continue;
+
+    // Formatted once for all clients
+    if (len < 0)
+    {
+      address_t &src = cemi_data->source;
+      len = snprintf_P(buf, sizeof(buf), PSTR("event: telegram\ndata: {\"source\":\"%u.%u.%u\",\"destination\":\"%u/%u/%u\",\"ct\":%u,\"data\":\""),
+        src.pa.area, src.pa.line, src.pa.member, dst.ga.area, dst.ga.line, dst.ga.member, ct);
+      for (uint8_t i = 0; i < data_len && len + 2 + 5 < (int)sizeof(buf); ++i)
+      {
+        len += snprintf_P(buf + len, sizeof(buf) - len, PSTR("%02x"), data[i]);
+      }
+      len += snprintf_P(buf + len, sizeof(buf) - len, PSTR("\"}\n\n"));
+    }
+
+    if (!__event_send(client, buf, len))
+      client.dropped++;
+  }
+}
+
+#if !DISABLE_CALLBACK_TIMING
+void ESPKNXIP::__event_slow_callback(slow_callback_t const &slow)
+{
+  char buf[112];
+  int len = snprintf_P(buf, sizeof(buf), PSTR("event: slow_callback\ndata: {\"id\":%u,\"destination\":\"%u/%u/%u\",\"duration_us\":%u}\n\n"),
+    slow.id, slow.address.ga.area, slow.address.ga.line, slow.address.ga.member, slow.duration);
+  for (uint8_t c = 0; c < MAX_EVENT_CLIENTS; ++c)
+  {
+    if (event_clients[c].client.connected())
+      __event_send(event_clients[c], buf, len);
+  }
+}
+#endif
+
+bool ESPKNXIP::__event_send(event_client_t &c, char const *data, uint16_t len)
+{
+  // write() would block until there is room, which would stall the KNX loop
+  if (c.client.availableForWrite() < len)
+    return false;
+  c.client.write((const uint8_t *)data, len);
+  c.last_send = millis();
+  return true;
+}
+
+#endif
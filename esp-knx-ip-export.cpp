@@ -0,0 +1,325 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+/**
+ * Export and import functions
+ * The binary export is an EEPROM image (see eeprom_record_tag_t), so a device can be provisioned with the export of
+ * another one in a single request. Items are identified by the hash of their name, records of items this firmware
+ * does not know are skipped on import. The JSON export is meant for reading and contains the same data, but it cannot
+ * be imported: only the binary export can be applied to a device.
+ */
+
+size_t ESPKNXIP::config_export(Print &out)
+{
+  size_t n = 0;
+  uint64_t magic = EEPROM_MAGIC;
+  n += out.write((uint8_t const *)&magic, sizeof(uint64_t));
+
+  n += __export_record(out, EEPROM_RECORD_PHYSADDR, 0, sizeof(address_t), physaddr.array);
+
+  for (callback_assignment_id_t i = 0; i < registered_callback_assignments; ++i)
+  {
+    uint8_t ga[] = {callback_assignments[i].address.bytes.high, callback_assignments[i].address.bytes.low};
+    n += __export_record(out, EEPROM_RECORD_ASSIGNMENT, callbacks[callback_assignments[i].callback_id].key, sizeof(ga), ga);
+  }
+
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    n += __export_record(out, EEPROM_RECORD_CONFIG, custom_configs[i].key, custom_configs[i].len, &custom_config_data[custom_configs[i].offset]);
+  }
+
+  n += out.write((uint8_t)EEPROM_RECORD_END);
+  return n;
+}
+
+size_t ESPKNXIP::__export_record(Print &out, eeprom_record_tag_t tag, uint32_t key, uint8_t len, uint8_t const *data)
+{
+  uint8_t header[EEPROM_RECORD_HEADER_SIZE] = {(uint8_t)tag, len};
+  for (uint8_t i = 0; i < sizeof(uint32_t); ++i)
+  {
+    header[2 + i] = (uint8_t)(key >> (i * 8));
+  }
+  return out.write(header, EEPROM_RECORD_HEADER_SIZE) + out.write(data, len);
+}
+
+/**
+ * Writes {"physical_address": "1.1.0", "assignments": [...], "configs": [...]}, see the __json_ functions below
+ */
+size_t ESPKNXIP::config_export_json(Print &out)
+{
+  size_t n = 0;
+  n += out.print(F("{\"physical_address\":"));
+  n += __json_physical_address(out);
+  n += out.print(F(",\"assignments\":"));
+  n += __json_assignments(out);
+  n += out.print(F(",\"configs\":"));
+  n += __json_configs(out);
+  n += out.print('}');
+  return n;
+}
+
+/**
+ * JSON functions
+ * Used by the JSON export and the JSON API. They print directly from the registries.
+ * Group addresses are written as "area/line/member", option values as numbers.
+ */
+
+size_t ESPKNXIP::__json_physical_address(Print &out)
+{
+  size_t n = out.print('"');
+  n += out.print(physaddr.pa.area);
+  n += out.print('.');
+  n += out.print(physaddr.pa.line);
+  n += out.print('.');
+  n += out.print(physaddr.pa.member);
+  return n + out.print('"');
+}
+
+/**
+ * Writes [{"id": 0, "ga": "1/2/3", "callback": "..."}, ...]
+ */
+size_t ESPKNXIP::__json_assignments(Print &out)
+{
+  size_t n = out.print('[');
+  for (callback_assignment_id_t i = 0; i < registered_callback_assignments; ++i)
+  {
+    address_t &addr = callback_assignments[i].address;
+    if (i > 0)
+      n += out.print(',');
+    n += out.print(F("{\"id\":"));
+    n += out.print(i);
+    n += out.print(F(",\"ga\":\""));
+    n += out.print(addr.ga.area);
+    n += out.print('/');
+    n += out.print(addr.ga.line);
+    n += out.print('/');
+    n += out.print(addr.ga.member);
+    n += out.print(F("\",\"callback\":"));
+    n += __export_json_string(out, (PGM_P)__string_pool_get(callbacks[callback_assignments[i].callback_id].name));
+    n += out.print('}');
+  }
+  return n + out.print(']');
+}
+
+/**
+ * Writes [{"id": 0, "name": "...", "set": true, "type": "int", "value": 42}, ...]
+ */
+size_t ESPKNXIP::__json_configs(Print &out)
+{
+  size_t n = out.print('[');
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    if (i > 0)
+      n += out.print(',');
+    n += out.print(F("{\"id\":"));
+    n += out.print(i);
+    n += out.print(F(",\"name\":"));
+    n += __export_json_string(out, (PGM_P)__string_pool_get(custom_configs[i].name));
+    n += out.print(F(",\"set\":"));
+    n += out.print((custom_config_data[custom_configs[i].offset] & CONFIG_FLAGS_VALUE_SET) ? F("true") : F("false"));
+    switch (custom_configs[i].type)
+    {
+      case CONFIG_TYPE_STRING:
+        n += out.print(F(",\"type\":\"string\",\"value\":"));
+        n += __export_json_string(out, config_get_string_view(i));
+        break;
+      case CONFIG_TYPE_INT:
+        n += out.print(F(",\"type\":\"int\",\"value\":"));
+        n += out.print(config_get_int(i));
+        break;
+      case CONFIG_TYPE_BOOL:
+        n += out.print(F(",\"type\":\"bool\",\"value\":"));
+        n += out.print(config_get_bool(i) ? F("true") : F("false"));
+        break;
+      case CONFIG_TYPE_OPTIONS:
+        n += out.print(F(",\"type\":\"options\",\"value\":"));
+        n += out.print(config_get_options(i));
+        break;
+      case CONFIG_TYPE_GA:
+      {
+        address_t a = config_get_ga(i);
+        n += out.print(F(",\"type\":\"ga\",\"value\":\""));
+        n += out.print(a.ga.area);
+        n += out.print('/');
+        n += out.print(a.ga.line);
+        n += out.print('/');
+        n += out.print(a.ga.member);
+        n += out.print('"');
+        break;
+      }
+      default:
+        break;
+    }
+    n += out.print('}');
+  }
+  return n + out.print(']');
+}
+
+/**
+ * Writes [{"id": 0, "name": "...", "type": "float", "value": 21.5}, ...]
+ * Feedbacks hidden by their enable condition are left out, actions have no value.
+ */
+size_t ESPKNXIP::__json_feedbacks(Print &out)
+{
+  size_t n = out.print('[');
+  bool first = true;
+  for (feedback_id_t i = 0; i < registered_feedbacks; ++i)
+  {
+    if (feedbacks[i].cond && !feedbacks[i].cond())
+      continue;
+    if (!first)
+      n += out.print(',');
+    first = false;
+    n += out.print(F("{\"id\":"));
+    n += out.print(i);
+    n += out.print(F(",\"name\":"));
+    n += __export_json_string(out, (PGM_P)__string_pool_get(feedbacks[i].name));
+    switch (feedbacks[i].type)
+    {
+      case FEEDBACK_TYPE_INT:
+        n += out.print(F(",\"type\":\"int\",\"value\":"));
+        n += out.print(*(int32_t *)feedbacks[i].data);
+        break;
+      case FEEDBACK_TYPE_FLOAT:
+      {
+        float val = *(float *)feedbacks[i].data;
+        n += out.print(F(",\"type\":\"float\",\"value\":"));
+        if (isnan(val) || isinf(val))
+        {
+          // Not representable in JSON
+          n += out.print(F("null"));
+          break;
+        }
+        char buf[33];
+        n += out.print(dtostrf(val, 1, feedbacks[i].options.float_options.precision, buf));
+        break;
+      }
+      case FEEDBACK_TYPE_BOOL:
+        n += out.print(F(",\"type\":\"bool\",\"value\":"));
+        n += out.print((*(bool *)feedbacks[i].data) ? F("true") : F("false"));
+        break;
+      case FEEDBACK_TYPE_ACTION:
+        n += out.print(F(",\"type\":\"action\""));
+        break;
+      default:
+        break;
+    }
+    n += out.print('}');
+  }
+  return n + out.print(']');
+}
+
+#if !DISABLE_CALLBACK_TIMING
+/**
+ * Writes [{"id": 0, "name": "...", "calls": 10, "slow": 0, "max_us": 180, "buckets": [{"le_us": 64, "count": 7}, ...]}, ...]
+ * Bucket counts are not cumulative, the last bucket has "le_us": null.
+ */
+size_t ESPKNXIP::__json_callbacks(Print &out)
+{
+  size_t n = out.print('[');
+  for (callback_id_t i = 0; i < registered_callbacks; ++i)
+  {
+    callback_timing_t &t = callbacks[i].timing;
+    if (i > 0)
+      n += out.print(',');
+    n += out.print(F("{\"id\":"));
+    n += out.print(i);
+    n += out.print(F(",\"name\":"));
+    n += __export_json_string(out, (PGM_P)__string_pool_get(callbacks[i].name));
+    n += out.print(F(",\"calls\":"));
+    n += out.print(callbacks[i].calls);
+    n += out.print(F(",\"slow\":"));
+    n += out.print(t.slow);
+    n += out.print(F(",\"max_us\":"));
+    n += out.print(t.max);
+    n += out.print(F(",\"buckets\":["));
+    for (uint8_t b = 0; b < __CALLBACK_TIMING_BUCKETS; ++b)
+    {
+      if (b > 0)
+        n += out.print(',');
+      n += out.print(F("{\"le_us\":"));
+      if (b < __CALLBACK_TIMING_BUCKETS - 1)
+        n += out.print(__callback_timing_limit(b));
+      else
+        n += out.print(F("null"));
+      n += out.print(F(",\"count\":"));
+      n += out.print(t.buckets[b]);
+      n += out.print('}');
+    }
+    n += out.print(F("]}"));
+  }
+  return n + out.print(']');
+}
+#endif
+
+/**
+ * Writes str quoted and escaped, str may be in flash or RAM
+ */
+size_t ESPKNXIP::__export_json_string(Print &out, PGM_P str)
+{
+  size_t n = out.print('"');
+  char c;
+  while ((c = pgm_read_byte(str++)) != 0)
+  {
+    if (c == '"' || c == '\\')
+    {
+      n += out.print('\\');
+      n += out.print(c);
+    }
+    else if ((uint8_t)c < 0x20)
+    {
+      n += out.printf_P(PSTR("\\u%04x"), c);
+    }
+    else
+    {
+      n += out.print(c);
+    }
+  }
+  return n + out.print('"');
+}
+
+/**
+ * Applies a binary export. The whole image is validated first and nothing is changed if it is invalid. Configs
+ * without a record are reset to their default and the assignments are replaced, then everything is saved at once.
+ */
+bool ESPKNXIP::config_import(uint8_t const *data, uint16_t len)
+{
+  uint64_t magic = 0;
+  if (len < sizeof(uint64_t))
+    return false;
+  memcpy(&magic, data, sizeof(uint64_t));
+  if (magic != EEPROM_MAGIC)
+  {
+    DEBUG_PRINTLN(F("Import has no valid magic"));
+    return false;
+  }
+  data += sizeof(uint64_t);
+  len -= sizeof(uint64_t);
+
+  if (!__eeprom_records_apply(data, len, true))
+  {
+    DEBUG_PRINTLN(F("Import is invalid"));
+    return false;
+  }
+
+  // Restored configs are marked dirty, the others had no record and are reset to their default. Resetting
+  // all of them first would notify subscribers twice.
+  __eeprom_mark_clean();
+  __eeprom_records_apply(data, len, false);
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    if (!custom_configs[i].dirty)
+      __config_set_default(i);
+  }
+
+  __eeprom_mark_all_dirty();
+  state_version++;
+  save_to_eeprom();
+  DEBUG_PRINTLN(F("Import applied"));
+  return true;
+}
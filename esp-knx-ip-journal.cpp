@@ -0,0 +1,262 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+#if USE_CONFIG_JOURNAL
+
+/**
+ * Journal functions
+ * Changes are appended as records to the active sector. When it is full, the next sector is erased and
+ * a snapshot of the whole config is written to it, so the wear is spread over all JOURNAL_SECTORS sectors.
+ * Restore only needs to read the newest sector, which bounds the replay to one sector.
+ */
+
+uint32_t ESPKNXIP::__journal_sector_address(uint8_t sector)
+{
+  // The journal is right below the EEPROM sector, see __journal_usable()
+  return (__eeprom_sector() - JOURNAL_SECTORS + sector) * SPI_FLASH_SEC_SIZE;
+}
+
+bool ESPKNXIP::__journal_append(journal_record_type_t type, uint32_t key, uint8_t len, uint8_t const *data)
+{
+  uint16_t size = sizeof(journal_record_t) + ((len + 3) & ~3);
+  if (journal_offset + size > SPI_FLASH_SEC_SIZE)
+    return false;
+
+  uint32_t buf[(sizeof(journal_record_t) + 0xFF + 3) / 4];
+  memset(buf, 0xFF, size);
+  journal_record_t *rec = (journal_record_t *)buf;
+  rec->type = type;
+  rec->len = len;
+  rec->key = key;
+  memcpy(((uint8_t *)buf) + sizeof(journal_record_t), data, len);
+  rec->crc = __crc16((uint8_t *)&rec->key, sizeof(uint32_t) + len, __crc16((uint8_t *)rec, 2));
+
+  if (!ESP.flashWrite(__journal_sector_address(journal_sector) + journal_offset, buf, size))
+    return false;
+
+  journal_offset += size;
+  eeprom_stats.last_bytes_written += size;
+  return true;
+}
+
+bool ESPKNXIP::__journal_append_assignment(callback_assignment_id_t id)
+{
+  uint32_t key = callbacks[callback_assignments[id].callback_id].key;
+  uint8_t entry[] = {
+    callback_assignments[id].address.bytes.high, callback_assignments[id].address.bytes.low,
+    (uint8_t)key, (uint8_t)(key >> 8), (uint8_t)(key >> 16), (uint8_t)(key >> 24)
+  };
+  return __journal_append(JOURNAL_RECORD_ASSIGNMENT, id, sizeof(entry), entry);
+}
+
+bool ESPKNXIP::__journal_write_snapshot(uint8_t sector)
+{
+  uint32_t address = __journal_sector_address(sector);
+  if (!ESP.flashEraseSector(address / SPI_FLASH_SEC_SIZE))
+    return false;
+
+  journal_sector = sector;
+  journal_offset = sizeof(journal_sector_t);
+
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    if (!__journal_append(JOURNAL_RECORD_CONFIG, custom_configs[i].key, custom_configs[i].len, &custom_config_data[custom_configs[i].offset]))
+      return false;
+  }
+
+  if (!__journal_append(JOURNAL_RECORD_ASSIGNMENT_COUNT, registered_callback_assignments, 0, nullptr))
+    return false;
+
+  for (callback_assignment_id_t i = 0; i < registered_callback_assignments; ++i)
+  {
+    if (!__journal_append_assignment(i))
+      return false;
+  }
+
+  if (!__journal_append(JOURNAL_RECORD_PHYSADDR, 0, sizeof(address_t), physaddr.array))
+    return false;
+
+  // The header is written last, so a snapshot interrupted by a power cut is never picked up by restore
+  journal_sector_t header = {JOURNAL_MAGIC, journal_sequence + 1};
+  if (!ESP.flashWrite(address, (uint32_t *)&header, sizeof(journal_sector_t)))
+    return false;
+
+  journal_sequence++;
+  eeprom_stats.last_bytes_written += sizeof(journal_sector_t);
+  return true;
+}
+
+bool ESPKNXIP::__journal_compact()
+{
+  uint8_t next = (journal_sector + 1) % JOURNAL_SECTORS;
+
+  DEBUG_PRINT("Compacting journal into sector ");
+  DEBUG_PRINTLN(next);
+
+  journal_valid = __journal_write_snapshot(next);
+  if (!journal_valid)
+  {
+    DEBUG_PRINTLN("Writing journal snapshot failed");
+  }
+  return journal_valid;
+}
+
+void ESPKNXIP::__journal_save()
+{
+  unsigned long start = micros();
+  bool ok = journal_valid;
+
+  eeprom_stats.last_bytes_written = 0;
+
+  for (config_id_t i = 0; ok && i < registered_configs; ++i)
+  {
+    if (custom_configs[i].dirty)
+      ok = __journal_append(JOURNAL_RECORD_CONFIG, custom_configs[i].key, custom_configs[i].len, &custom_config_data[custom_configs[i].offset]);
+  }
+
+  if (ok && eeprom_assignments_dirty_from < MAX_CALLBACK_ASSIGNMENTS)
+  {
+    ok = __journal_append(JOURNAL_RECORD_ASSIGNMENT_COUNT, registered_callback_assignments, 0, nullptr);
+    for (callback_assignment_id_t i = eeprom_assignments_dirty_from; ok && i < registered_callback_assignments; ++i)
+    {
+      ok = __journal_append_assignment(i);
+    }
+  }
+
+  if (ok && (eeprom_dirty & EEPROM_DIRTY_PHYSADDR))
+    ok = __journal_append(JOURNAL_RECORD_PHYSADDR, 0, sizeof(address_t), physaddr.array);
+
+  // Sector is full or unusable, a snapshot in the next sector contains all changes
+  if (!ok)
+    ok = __journal_compact();
+
+  if (ok)
+    __eeprom_mark_clean();
+
+  eeprom_stats.bytes_written += eeprom_stats.last_bytes_written;
+  eeprom_stats.last_commit_time = micros() - start;
+  if (eeprom_stats.last_bytes_written > 0)
+    eeprom_stats.commits++;
+
+  DEBUG_PRINT("Appended ");
+  DEBUG_PRINT(eeprom_stats.last_bytes_written);
+  DEBUG_PRINT(" bytes to journal in ");
+  DEBUG_PRINT(eeprom_stats.last_commit_time);
+  DEBUG_PRINTLN("us");
+}
+
+void ESPKNXIP::__journal_restore()
+{
+  bool found = false;
+  journal_valid = false;
+  eeprom_stats.last_restore_records = 0;
+
+  for (uint8_t i = 0; i < JOURNAL_SECTORS; ++i)
+  {
+    journal_sector_t header;
+    if (!ESP.flashRead(__journal_sector_address(i), (uint32_t *)&header, sizeof(journal_sector_t)))
+      continue;
+    if (header.magic != JOURNAL_MAGIC)
+      continue;
+    if (!found || (int32_t)(header.sequence - journal_sequence) > 0)
+    {
+      found = true;
+      journal_sector = i;
+      journal_sequence = header.sequence;
+    }
+  }
+
+  if (!found)
+  {
+    DEBUG_PRINTLN("No valid journal sector, aborting restore.");
+    __eeprom_mark_all_dirty();
+    return;
+  }
+
+  uint32_t address = __journal_sector_address(journal_sector);
+  uint32_t buf[(sizeof(journal_record_t) + 0xFF + 3) / 4];
+  journal_record_t *rec = (journal_record_t *)buf;
+  uint8_t *data = ((uint8_t *)buf) + sizeof(journal_record_t);
+  bool torn = false;
+
+  journal_offset = sizeof(journal_sector_t);
+  while (journal_offset + sizeof(journal_record_t) <= SPI_FLASH_SEC_SIZE)
+  {
+    ESP.flashRead(address + journal_offset, buf, sizeof(journal_record_t));
+    if (rec->type == JOURNAL_RECORD_FREE)
+      break;
+
+    uint16_t size = sizeof(journal_record_t) + ((rec->len + 3) & ~3);
+    if (journal_offset + size > SPI_FLASH_SEC_SIZE)
+    {
+      torn = true;
+      break;
+    }
+    if (size > sizeof(journal_record_t))
+      ESP.flashRead(address + journal_offset + sizeof(journal_record_t), (uint32_t *)data, size - sizeof(journal_record_t));
+    if (rec->crc != __crc16((uint8_t *)&rec->key, sizeof(uint32_t) + rec->len, __crc16((uint8_t *)rec, 2)))
+    {
+      torn = true;
+      break;
+    }
+
+    switch (rec->type)
+    {
+      case JOURNAL_RECORD_CONFIG:
+      {
+        config_id_t id = __config_find_key(rec->key);
+        if (id != (config_id_t)-1)
+          __config_restore(id, rec->len, data);
+        break;
+      }
+      case JOURNAL_RECORD_ASSIGNMENT_COUNT:
+        if (__callback_assignments_reserve(rec->key))
+          registered_callback_assignments = rec->key;
+        break;
+      case JOURNAL_RECORD_ASSIGNMENT:
+        if (rec->len == 6 && __callback_assignments_reserve(rec->key + 1))
+        {
+          callback_assignments[rec->key].address.bytes.high = data[0];
+          callback_assignments[rec->key].address.bytes.low = data[1];
+          // Unknown callbacks are marked here and removed after the replay, later records may still overwrite them
+          callback_assignments[rec->key].callback_id = __callback_find_key(data[2] | (data[3] << 8) | (data[4] << 16) | ((uint32_t)data[5] << 24));
+        }
+        break;
+      case JOURNAL_RECORD_PHYSADDR:
+        if (rec->len == sizeof(address_t))
+          memcpy(physaddr.array, data, sizeof(address_t));
+        break;
+    }
+
+    journal_offset += size;
+    eeprom_stats.last_restore_records++;
+  }
+
+  __eeprom_mark_clean();
+
+  for (callback_assignment_id_t i = registered_callback_assignments; i > 0; --i)
+  {
+    if (callback_assignments[i - 1].callback_id == (callback_id_t)-1)
+    {
+      DEBUG_PRINTLN("Skipping assignment of unknown callback");
+      __callback_delete_assignment(i - 1);
+    }
+  }
+
+  // A torn record can not be overwritten, the next save starts a new sector
+  journal_valid = !torn;
+
+  DEBUG_PRINT("Restored ");
+  DEBUG_PRINT(eeprom_stats.last_restore_records);
+  DEBUG_PRINT(" records from journal sector ");
+  DEBUG_PRINT(journal_sector);
+  DEBUG_PRINT(torn ? " (torn) @ 0x" : " @ 0x");
+  DEBUG_PRINTLN(journal_offset, HEX);
+}
+
+#endif
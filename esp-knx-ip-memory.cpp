@@ -0,0 +1,91 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+#if !DISABLE_MEMORY_STATS
+
+/**
+ * Memory statistics functions
+ * Every web handler and save is wrapped in a probe that keeps the free heap and the largest free block before and
+ * after the last call and the worst values seen. A handler that leaves less heap behind than it found, or a largest
+ * block that keeps shrinking while the free heap stays, shows up here long before an allocation fails.
+ * The stack depth of loop() is sampled at the variable length arrays in __loop_knx() and __send() and before each
+ * callback, which are the deepest points the library reaches.
+ */
+
+static uint16_t __memory_clamp(uint32_t bytes)
+{
+  return bytes > 0xFFFF ? 0xFFFF : bytes;
+}
+
+void ESPKNXIP::__memory_probe_begin(memory_probe_t &probe)
+{
+  probe.heap_before = __memory_clamp(ESP.getFreeHeap());
+#if __CORE_HAS_HEAP_STATS
+  probe.block_before = __memory_clamp(ESP.getMaxFreeBlockSize());
+#endif
+}
+
+void ESPKNXIP::__memory_probe_end(memory_probe_t &probe)
+{
+  probe.heap_after = __memory_clamp(ESP.getFreeHeap());
+#if __CORE_HAS_HEAP_STATS
+  probe.block_after = __memory_clamp(ESP.getMaxFreeBlockSize());
+#endif
+  if (probe.calls == 0 || probe.heap_after < probe.heap_min)
+    probe.heap_min = probe.heap_after;
+  if (probe.calls == 0 || probe.block_after < probe.block_min)
+    probe.block_min = probe.block_after;
+  if (probe.heap_before > probe.heap_after && probe.heap_before - probe.heap_after > probe.heap_kept_max)
+    probe.heap_kept_max = probe.heap_before - probe.heap_after;
+  probe.calls++;
+}
+
+void ESPKNXIP::__memory_probe_print(Print &out, memory_probe_t const &probe)
+{
+  out.print(FPSTR(probe.name));
+  out.printf_P(PSTR(": %u calls, heap %u -> %u (min %u, kept %u), block %u -> %u (min %u)\n"),
+    probe.calls, probe.heap_before, probe.heap_after, probe.heap_min, probe.heap_kept_max,
+    probe.block_before, probe.block_after, probe.block_min);
+}
+
+size_t ESPKNXIP::__json_memory_probe(Print &out, memory_probe_t const &probe)
+{
+  size_t n = out.print(F("{\"name\":"));
+  n += __export_json_string(out, probe.name);
+  n += out.printf_P(PSTR(",\"calls\":%u,\"heap_before\":%u,\"heap_after\":%u,\"heap_min\":%u,\"heap_kept_max\":%u,\"block_before\":%u,\"block_after\":%u,\"block_min\":%u}"),
+    probe.calls, probe.heap_before, probe.heap_after, probe.heap_min, probe.heap_kept_max,
+    probe.block_before, probe.block_after, probe.block_min);
+  return n;
+}
+
+/**
+ * Writes {"heap": {"free": 30000, "max_block": 20000, "fragmentation": 12}, "stack": {"loop_max": 600, "free_min": 2000},
+ * "probes": [{"name": "save", ...}, {"name": "/", ...}, ...]}
+ * max_block, fragmentation and free_min are null on cores before 2.5.0. The request being answered is still running,
+ * so its own probe shows the previous request.
+ */
+size_t ESPKNXIP::__json_memory(Print &out)
+{
+  size_t n = out.print(F("{\"heap\":{\"free\":"));
+  n += out.print(ESP.getFreeHeap());
+#if __CORE_HAS_HEAP_STATS
+  n += out.printf_P(PSTR(",\"max_block\":%u,\"fragmentation\":%u},\"stack\":{\"loop_max\":%u,\"free_min\":%u},\"probes\":["),
+    ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation(), stack_max, ESP.getFreeContStack());
+#else
+  n += out.printf_P(PSTR(",\"max_block\":null,\"fragmentation\":null},\"stack\":{\"loop_max\":%u,\"free_min\":null},\"probes\":["), stack_max);
+#endif
+  n += __json_memory_probe(out, memory_save);
+  for (uint16_t i = 0; i < memory_probes_count; ++i)
+  {
+    n += out.print(',');
+    n += __json_memory_probe(out, memory_probes[i]);
+  }
+  return n + out.print(F("]}"));
+}
+
+#endif
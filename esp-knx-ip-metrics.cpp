@@ -0,0 +1,212 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+#if !DISABLE_METRICS
+
+/**
+ * Metrics functions
+ * Serves the counters in the Prometheus text format. Everything is printed straight from the counters into the
+ * response, a scrape allocates nothing besides what the webserver needs for the headers.
+ */
+
+void ESPKNXIP::__handle_metrics()
+{
+  ChunkedWriter m(server);
+  m.begin(200, F("text/plain; version=0.0.4"));
+
+  // Protocol
+  __metric(m, PSTR("esp_knx_received_packets_total"), PSTR("counter"), PSTR("UDP packets received on the KNX multicast group."), metrics.rx_packets);
+  __metric(m, PSTR("esp_knx_dropped_packets_total"), PSTR("counter"), PSTR("Received packets that were no KNX routing indications carrying data."), metrics.rx_dropped);
+  __metric(m, PSTR("esp_knx_received_telegrams_total"), PSTR("counter"), PSTR("Group telegrams passed to read requests and callbacks."), metrics.rx_telegrams);
+  __metric(m, PSTR("esp_knx_sent_telegrams_total"), PSTR("counter"), PSTR("Telegrams sent."), metrics.tx_telegrams);
+  __metric(m, PSTR("esp_knx_send_failures_total"), PSTR("counter"), PSTR("Telegrams the UDP stack did not accept."), metrics.tx_failed);
+
+  __metric(m, PSTR("esp_knx_callback_calls_total"), PSTR("counter"), PSTR("Telegrams passed to each callback."));
+  for (callback_id_t i = 0; i < registered_callbacks; ++i)
+  {
+    m.print(F("esp_knx_callback_calls_total{"));
+    __metric_callback_labels(m, i);
+    m.print(F("} "));
+    m.print(callbacks[i].calls);
+    m.print('\n');
+  }
+
+#if !DISABLE_CALLBACK_TIMING
+  // Buckets are cumulative here
+  __metric(m, PSTR("esp_knx_callback_duration_seconds"), PSTR("histogram"), PSTR("Duration of callback calls."));
+  for (callback_id_t i = 0; i < registered_callbacks; ++i)
+  {
+    callback_timing_t &t = callbacks[i].timing;
+    uint32_t count = 0;
+    for (uint8_t b = 0; b < __CALLBACK_TIMING_BUCKETS; ++b)
+    {
+      count += t.buckets[b];
+      m.print(F("esp_knx_callback_duration_seconds_bucket{"));
+      __metric_callback_labels(m, i);
+      m.print(F(",le=\""));
+      if (b < __CALLBACK_TIMING_BUCKETS - 1)
+        m.print(__callback_timing_limit(b) / 1000000.0, 6);
+      else
+        m.print(F("+Inf"));
+      m.print(F("\"} "));
+      m.print(count);
+      m.print('\n');
+    }
+    m.print(F("esp_knx_callback_duration_seconds_sum{"));
+    __metric_callback_labels(m, i);
+    m.print(F("} "));
+    m.print(t.total / 1000000.0, 6);
+    m.print(F("\nesp_knx_callback_duration_seconds_count{"));
+    __metric_callback_labels(m, i);
+    m.print(F("} "));
+    m.print(count);
+    m.print('\n');
+  }
+  __metric(m, PSTR("esp_knx_callback_slow_calls_total"), PSTR("counter"), PSTR("Callback calls longer than SLOW_CALLBACK_THRESHOLD."));
+  for (callback_id_t i = 0; i < registered_callbacks; ++i)
+  {
+    m.print(F("esp_knx_callback_slow_calls_total{"));
+    __metric_callback_labels(m, i);
+    m.print(F("} "));
+    m.print(callbacks[i].timing.slow);
+    m.print('\n');
+  }
+#endif
+
+  // Loop
+  __metric(m, PSTR("esp_knx_loop_iterations_total"), PSTR("counter"), PSTR("Calls of loop()."), metrics.loops);
+  __metric(m, PSTR("esp_knx_loop_duration_seconds_total"), PSTR("counter"), PSTR("Time spent in loop()."));
+  m.print(F("esp_knx_loop_duration_seconds_total "));
+  m.print(metrics.loop_time / 1000000.0, 6);
+  m.print('\n');
+  __metric(m, PSTR("esp_knx_loop_duration_max_seconds"), PSTR("gauge"), PSTR("Duration of the longest call of loop() since boot."));
+  m.print(F("esp_knx_loop_duration_max_seconds "));
+  m.print(metrics.loop_time_max / 1000000.0, 6);
+  m.print('\n');
+
+  __metric(m, PSTR("esp_knx_loop_phase_mean_seconds"), PSTR("gauge"), PSTR("Moving average of the duration of each part of loop()."));
+  for (uint8_t i = 0; i < LOOP_PHASE_COUNT; ++i)
+  {
+    m.print(F("esp_knx_loop_phase_mean_seconds{phase=\""));
+    m.print(FPSTR(__loop_phase_name((loop_phase_t)i)));
+    m.print(F("\"} "));
+    m.print(loop_phases[i].mean / 16000000.0, 6);
+    m.print('\n');
+  }
+  __metric(m, PSTR("esp_knx_loop_phase_max_seconds"), PSTR("gauge"), PSTR("Longest duration of each part of loop() in the last LOOP_PROFILE_WINDOW."));
+  for (uint8_t i = 0; i < LOOP_PHASE_COUNT; ++i)
+  {
+    m.print(F("esp_knx_loop_phase_max_seconds{phase=\""));
+    m.print(FPSTR(__loop_phase_name((loop_phase_t)i)));
+    m.print(F("\"} "));
+    m.print(__loop_phase_max((loop_phase_t)i) / 1000000.0, 6);
+    m.print('\n');
+  }
+  __metric(m, PSTR("esp_knx_loop_phase_deferred_total"), PSTR("counter"), PSTR("Calls of loop() in which a part waited because LOOP_BUDGET was used up."));
+  for (uint8_t i = 0; i < LOOP_PHASE_COUNT; ++i)
+  {
+    m.print(F("esp_knx_loop_phase_deferred_total{phase=\""));
+    m.print(FPSTR(__loop_phase_name((loop_phase_t)i)));
+    m.print(F("\"} "));
+    m.print(loop_phases[i].deferred);
+    m.print('\n');
+  }
+
+  // Device
+  __metric(m, PSTR("esp_knx_uptime_seconds"), PSTR("gauge"), PSTR("Time since boot."), millis() / 1000);
+  __metric(m, PSTR("esp_knx_heap_free_bytes"), PSTR("gauge"), PSTR("Free heap."), ESP.getFreeHeap());
+#if __CORE_HAS_HEAP_STATS
+  __metric(m, PSTR("esp_knx_heap_max_block_bytes"), PSTR("gauge"), PSTR("Largest block that can be allocated."), ESP.getMaxFreeBlockSize());
+  __metric(m, PSTR("esp_knx_heap_fragmentation_percent"), PSTR("gauge"), PSTR("Heap fragmentation, 0 is none."), ESP.getHeapFragmentation());
+#endif
+#if !DISABLE_MEMORY_STATS
+  __metric(m, PSTR("esp_knx_stack_loop_max_bytes"), PSTR("gauge"), PSTR("Deepest stack use below loop() since boot."), stack_max);
+#if __CORE_HAS_HEAP_STATS
+  __metric(m, PSTR("esp_knx_stack_free_min_bytes"), PSTR("gauge"), PSTR("Stack that was never used since boot."), ESP.getFreeContStack());
+#endif
+  __metric(m, PSTR("esp_knx_probe_heap_min_bytes"), PSTR("gauge"), PSTR("Lowest free heap after a web handler or save."));
+  __metric_probes(m, PSTR("esp_knx_probe_heap_min_bytes"), offsetof(memory_probe_t, heap_min));
+  __metric(m, PSTR("esp_knx_probe_heap_kept_max_bytes"), PSTR("gauge"), PSTR("Most heap a single call of a web handler or save did not give back."));
+  __metric_probes(m, PSTR("esp_knx_probe_heap_kept_max_bytes"), offsetof(memory_probe_t, heap_kept_max));
+#if __CORE_HAS_HEAP_STATS
+  __metric(m, PSTR("esp_knx_probe_block_min_bytes"), PSTR("gauge"), PSTR("Smallest largest free block after a web handler or save."));
+  __metric_probes(m, PSTR("esp_knx_probe_block_min_bytes"), offsetof(memory_probe_t, block_min));
+#endif
+#endif
+  __metric(m, PSTR("esp_knx_eeprom_saves_total"), PSTR("counter"), PSTR("Saves of the configuration."), eeprom_stats.saves);
+  __metric(m, PSTR("esp_knx_eeprom_commits_total"), PSTR("counter"), PSTR("Saves that wrote to flash."), eeprom_stats.commits);
+  __metric(m, PSTR("esp_knx_eeprom_written_bytes_total"), PSTR("counter"), PSTR("Bytes written to flash by saves."), eeprom_stats.bytes_written);
+  __metric(m, PSTR("esp_knx_web_requests_total"), PSTR("counter"), PSTR("Requests handled by the web ui and APIs, including this one."), metrics.web_requests);
+
+  m.end();
+}
+
+void ESPKNXIP::__metric_callback_labels(Print &out, callback_id_t id)
+{
+  out.print(F("id=\""));
+  out.print(id);
+  out.print(F("\",callback=\""));
+  // Label values escape backslash, quote and newline
+  PGM_P name = (PGM_P)__string_pool_get(callbacks[id].name);
+  char c;
+  while ((c = pgm_read_byte(name++)) != 0)
+  {
+    if (c == '\\' || c == '"')
+      out.print('\\');
+    if (c == '\n')
+    {
+      out.print(F("\\n"));
+      continue;
+    }
+    out.print(c);
+  }
+  out.print('"');
+}
+
+#if !DISABLE_MEMORY_STATS
+/**
+ * Prints the uint16_t at offset of every memory probe, labeled with the probe name
+ */
+void ESPKNXIP::__metric_probes(Print &out, PGM_P name, size_t offset)
+{
+  for (int32_t i = -1; i < memory_probes_count; ++i)
+  {
+    memory_probe_t const &probe = i < 0 ? memory_save : memory_probes[i];
+    out.print(FPSTR(name));
+    out.print(F("{probe=\""));
+    out.print(FPSTR(probe.name));
+    out.print(F("\"} "));
+    out.print(*(uint16_t const *)((uint8_t const *)&probe + offset));
+    out.print('\n');
+  }
+}
+#endif
+
+void ESPKNXIP::__metric(Print &out, PGM_P name, PGM_P type, PGM_P help)
+{
+  out.print(F("# HELP "));
+  out.print(FPSTR(name));
+  out.print(' ');
+  out.print(FPSTR(help));
+  out.print(F("\n# TYPE "));
+  out.print(FPSTR(name));
+  out.print(' ');
+  out.print(FPSTR(type));
+  out.print('\n');
+}
+
+void ESPKNXIP::__metric(Print &out, PGM_P name, PGM_P type, PGM_P help, uint32_t value)
+{
+  __metric(out, name, type, help);
+  out.print(FPSTR(name));
+  out.print(' ');
+  out.print(value);
+  out.print('\n');
+}
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+#if !DISABLE_BUS_MONITOR
+
+/**
+ * Bus monitor functions
+ * Every received group telegram that passes the filters is copied into a ring of BUS_MONITOR_SIZE entries, so the
+ * monitor can stay enabled without slowing down the KNX loop. Telegrams are numbered, clients ask for all telegrams
+ * after the last number they got and learn how many were overwritten in between.
+ */
+
+void ESPKNXIP::__monitor_capture(cemi_service_t *cemi_data)
+{
+  if (cemi_data->data_len == 0)
+    return;
+  if (!__address_filter_match(monitor_filter_ga, cemi_data->destination) || !__address_filter_match(monitor_filter_source, cemi_data->source))
+    return;
+
+  monitor_entry_t &e = monitor[monitor_next % BUS_MONITOR_SIZE];
+  e.time = millis();
+  e.source = cemi_data->source;
+  e.destination = cemi_data->destination;
+  e.ct = ((cemi_data->data[0] & 0xC0) >> 6) | ((cemi_data->pci.apci & 0x03) << 2);
+  e.data_len = cemi_data->data_len;
+  memcpy(e.data, cemi_data->data, e.data_len < BUS_MONITOR_DATA_LEN ? e.data_len : BUS_MONITOR_DATA_LEN);
+  e.data[0] &= 0x3F;
+  monitor_next++;
+}
+
+bool ESPKNXIP::monitor_set_filter(String ga, String source)
+{
+  address_filter_t f_ga, f_source;
+  if (!__address_filter_parse(ga, f_ga, true) || !__address_filter_parse(source, f_source, false))
+    return false;
+  monitor_filter_ga = f_ga;
+  monitor_filter_source = f_source;
+  return true;
+}
+
+void ESPKNXIP::monitor_clear()
+{
+  // The numbering continues, so clients polling with the last number do not miss new telegrams
+  for (uint32_t i = 0; i < BUS_MONITOR_SIZE; ++i)
+  {
+    monitor[i].data_len = 0;
+  }
+}
+
+/**
+ * Writes {"next": 42, "lost": 0, "filter": {...}, "telegrams": [...]} with all telegrams numbered since or higher.
+ * lost is the number of those that were already overwritten, next is the since for the following request.
+ */
+size_t ESPKNXIP::__json_monitor(Print &out, uint32_t since)
+{
+  uint32_t first = monitor_next > BUS_MONITOR_SIZE ? monitor_next - BUS_MONITOR_SIZE : 0;
+  uint32_t lost = 0;
+  if (since > monitor_next)
+    since = first; // From before a reboot
+  if (since < first)
+  {
+    lost = first - since;
+    since = first;
+  }
+
+  size_t n = out.print(F("{\"next\":"));
+  n += out.print(monitor_next);
+  n += out.print(F(",\"lost\":"));
+  n += out.print(lost);
+  n += out.print(F(",\"filter\":{\"ga\":\""));
+  n += __address_filter_print(out, monitor_filter_ga, true);
+  n += out.print(F("\",\"source\":\""));
+  n += __address_filter_print(out, monitor_filter_source, false);
+  n += out.print(F("\"},\"telegrams\":["));
+  bool first_entry = true;
+  for (uint32_t i = since; i < monitor_next; ++i)
+  {
+    monitor_entry_t &e = monitor[i % BUS_MONITOR_SIZE];
+    // Cleared
+    if (e.data_len == 0)
+      continue;
+    if (!first_entry)
+      n += out.print(',');
+    first_entry = false;
+    n += out.printf_P(PSTR("{\"n\":%u,\"time\":%u,\"source\":\"%u.%u.%u\",\"destination\":\"%u/%u/%u\",\"ct\":%u,\"length\":%u,\"data\":\""),
+      i, e.time, e.source.pa.area, e.source.pa.line, e.source.pa.member,
+      e.destination.ga.area, e.destination.ga.line, e.destination.ga.member, e.ct, e.data_len);
+    for (uint8_t j = 0; j < e.data_len && j < BUS_MONITOR_DATA_LEN; ++j)
+    {
+      n += out.printf_P(PSTR("%02x"), e.data[j]);
+    }
+    n += out.print(F("\"}"));
+  }
+  return n + out.print(F("]}"));
+}
+
+void ESPKNXIP::__handle_monitor_api()
+{
+  uint32_t since = 0;
+  if (server->hasArg(F("since")))
+    since = strtoul(server->arg(F("since")).c_str(), nullptr, 10);
+
+  ChunkedWriter out(server);
+  out.begin(200, F("application/json"));
+  __json_monitor(out, since);
+  out.end();
+}
+
+#endif
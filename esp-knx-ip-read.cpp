@@ -0,0 +1,366 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+/**
+ * Read request functions
+ * A read request sends a GroupValueRead and waits for the answer or a timeout.
+ * The result is delivered to the callback, if one was given. Otherwise the request stays in the table
+ * until it is polled with read_request_state()/read_request_result() and freed with read_request_release().
+ * Results that are never released are freed after READ_REQUEST_RESULT_LIFETIME, so a forgotten request does not
+ * keep its slot forever.
+ */
+
+read_request_id_t ESPKNXIP::read_request(address_t const &address, read_result_fptr_t cb, void *arg, uint16_t timeout)
+{
+  if (address.value == 0)
+    return READ_REQUEST_INVALID;
+
+  for (read_request_id_t i = 0; i < MAX_READ_REQUESTS; ++i)
+  {
+    if (read_requests[i].state != READ_STATE_FREE)
+      continue;
+
+    read_requests[i].state = READ_STATE_PENDING;
+    read_requests[i].address = address;
+    read_requests[i].sent = false;
+    read_requests[i].started = millis();
+    read_requests[i].timeout = timeout;
+    read_requests[i].fkt = cb;
+    read_requests[i].arg = arg;
+    read_requests[i].data_len = 0;
+
+    __read_request_send_pending();
+
+    return i;
+  }
+
+  DEBUG_PRINTLN(F("No free read request slot"));
+  return READ_REQUEST_INVALID;
+}
+
+read_state_t ESPKNXIP::read_request_state(read_request_id_t id)
+{
+  if (id >= MAX_READ_REQUESTS)
+    return READ_STATE_FREE;
+
+  return read_requests[id].state;
+}
+
+bool ESPKNXIP::read_request_result(read_request_id_t id, message_t &msg)
+{
+  if (id >= MAX_READ_REQUESTS || read_requests[id].state != READ_STATE_ANSWERED)
+    return false;
+
+  msg.ct = KNX_CT_ANSWER;
+  msg.received_on = read_requests[id].address;
+  msg.data_len = read_requests[id].data_len;
+  msg.data = read_requests[id].data;
+  return true;
+}
+
+void ESPKNXIP::read_request_release(read_request_id_t id)
+{
+  if (id >= MAX_READ_REQUESTS)
+    return;
+
+  read_requests[id].state = READ_STATE_FREE;
+}
+
+/**
+ * Sends a GroupValueRead for every pending request whose address has no read on the bus yet
+ */
+void ESPKNXIP::__read_request_send_pending()
+{
+  for (read_request_id_t i = 0; i < MAX_READ_REQUESTS; ++i)
+  {
+    if (read_requests[i].state != READ_STATE_PENDING || read_requests[i].sent)
+      continue;
+
+    bool in_flight = false;
+    for (read_request_id_t j = 0; j < MAX_READ_REQUESTS; ++j)
+    {
+      if (read_requests[j].state == READ_STATE_PENDING && read_requests[j].sent && read_requests[j].address.value == read_requests[i].address.value)
+      {
+        in_flight = true;
+        break;
+      }
+    }
+
+    if (in_flight)
+      continue;
+
+    read_requests[i].sent = true;
+    read_requests[i].started = millis();
+    send_1bit(read_requests[i].address, KNX_CT_READ, 0);
+  }
+}
+
+void ESPKNXIP::__read_request_resolve(address_t const &address, uint8_t data_len, uint8_t *data)
+{
+  if (data_len > READ_REQUEST_MAX_DATA)
+    data_len = READ_REQUEST_MAX_DATA;
+
+  for (read_request_id_t i = 0; i < MAX_READ_REQUESTS; ++i)
+  {
+    if (read_requests[i].state != READ_STATE_PENDING || read_requests[i].address.value != address.value)
+      continue;
+
+    DEBUG_PRINT(F("Read request answered: "));
+    DEBUG_PRINTLN(i);
+
+    read_requests[i].state = READ_STATE_ANSWERED;
+    read_requests[i].data_len = data_len;
+    memcpy(read_requests[i].data, data, data_len);
+    __read_request_finish(i);
+  }
+}
+
+void ESPKNXIP::__read_request_finish(read_request_id_t id)
+{
+  if (read_requests[id].fkt == nullptr)
+  {
+    // Kept for polling, see READ_REQUEST_RESULT_LIFETIME
+    read_requests[id].started = millis();
+    return;
+  }
+
+  message_t msg = {};
+  msg.ct = KNX_CT_ANSWER;
+  msg.received_on = read_requests[id].address;
+  msg.data_len = read_requests[id].data_len;
+  msg.data = read_requests[id].data;
+
+  // Free the slot before calling, so the callback can issue a new read right away
+  read_state_t state = read_requests[id].state;
+  read_requests[id].state = READ_STATE_FREE;
+  read_requests[id].fkt(state, msg, read_requests[id].arg);
+}
+
+void ESPKNXIP::__loop_read_requests()
+{
+  unsigned long now = millis();
+  bool timed_out = false;
+
+  for (read_request_id_t i = 0; i < MAX_READ_REQUESTS; ++i)
+  {
+#if READ_REQUEST_RESULT_LIFETIME > 0
+    if ((read_requests[i].state == READ_STATE_ANSWERED || read_requests[i].state == READ_STATE_TIMEOUT) && now - read_requests[i].started >= READ_REQUEST_RESULT_LIFETIME)
+    {
+      DEBUG_PRINT(F("Read request result expired: "));
+      DEBUG_PRINTLN(i);
+      read_requests[i].state = READ_STATE_FREE;
+      continue;
+    }
+#endif
+    if (read_requests[i].state != READ_STATE_PENDING || !read_requests[i].sent)
+      continue;
+
+    if (now - read_requests[i].started < read_requests[i].timeout)
+      continue;
+
+    DEBUG_PRINT(F("Read request timed out: "));
+    DEBUG_PRINTLN(i);
+
+    read_requests[i].state = READ_STATE_TIMEOUT;
+    read_requests[i].data_len = 0;
+    timed_out = true;
+    __read_request_finish(i);
+  }
+
+  // Coalesced requests whose read timed out get their own read now
+  if (timed_out)
+    __read_request_send_pending();
+}
+
+/**
+ * Startup sync functions
+ * After start(), all GAs assigned to callbacks flagged with callback_set_sync() and all GA configs flagged
+ * with config_set_sync() are read, one every SYNC_INTERVAL ms. Missing answers are read again up to
+ * SYNC_RETRIES times, then the done callback is called with the number of GAs that never answered.
+ */
+
+void ESPKNXIP::sync_start()
+{
+  if (sync.running)
+    return;
+
+  sync.item_count = registered_callback_assignments + registered_configs;
+  sync.round = 0;
+  sync.next_item = 0;
+  sync.outstanding = 0;
+  sync.done = (uint8_t *)calloc((sync.item_count + 7) / 8 + 1, sizeof(uint8_t));
+  if (sync.done == nullptr)
+  {
+    DEBUG_PRINTLN(F("Not enough memory for sync"));
+    return;
+  }
+  sync.running = true;
+  sync.next_send = millis() + __device_hash(0x53594e43) % (SYNC_JITTER + 1);
+
+  DEBUG_PRINT(F("Sync starts in "));
+  DEBUG_PRINT(sync.next_send - millis());
+  DEBUG_PRINTLN(F("ms"));
+}
+
+bool ESPKNXIP::sync_running()
+{
+  return sync.running;
+}
+
+void ESPKNXIP::sync_register_done(sync_done_fptr_t fkt, void *arg)
+{
+  sync.fkt = fkt;
+  sync.arg = arg;
+}
+
+/**
+ * Returns true, if the item needs to be synced and sets address to the GA to read
+ */
+bool ESPKNXIP::__sync_item_address(uint16_t item, address_t &address)
+{
+  if (item < registered_callback_assignments)
+  {
+    callback_t &cb = callbacks[callback_assignments[item].callback_id];
+    if (!cb.sync || (cb.cond && !cb.cond()))
+      return false;
+    address = callback_assignments[item].address;
+  }
+  else if (item - registered_callback_assignments < registered_configs)
+  {
+    config_id_t id = item - registered_callback_assignments;
+    if (!custom_configs[id].sync || (custom_configs[id].cond && !custom_configs[id].cond()))
+      return false;
+    address = config_get_ga(id);
+  }
+  else
+  {
+    return false;
+  }
+
+  return address.value != 0;
+}
+
+void ESPKNXIP::__sync_read_result(read_state_t state, message_t const &msg, void *arg)
+{
+  ((ESPKNXIP *)arg)->__sync_result(state, msg);
+}
+
+void ESPKNXIP::__sync_result(read_state_t state, message_t const &msg)
+{
+  if (!sync.running)
+    return;
+
+  if (sync.outstanding > 0)
+    sync.outstanding--;
+
+  if (state != READ_STATE_ANSWERED)
+    return;
+
+  // Several items can share a GA, all of them are answered at once
+  for (uint16_t i = 0; i < sync.item_count; ++i)
+  {
+    address_t address;
+    if ((sync.done[i / 8] & (1 << (i % 8))) || !__sync_item_address(i, address) || address.value != msg.received_on.value)
+      continue;
+
+    sync.done[i / 8] |= (1 << (i % 8));
+
+    // Answers to assigned GAs already reached their callbacks, config GAs are passed on here
+    if (i >= registered_callback_assignments)
+    {
+      __callback_call(custom_configs[i - registered_callback_assignments].sync_callback, msg);
+    }
+  }
+}
+
+void ESPKNXIP::__sync_finish(uint16_t missing)
+{
+  DEBUG_PRINT(F("Sync done, missing: "));
+  DEBUG_PRINTLN(missing);
+
+  sync.running = false;
+  free(sync.done);
+  sync.done = nullptr;
+
+  if (sync.fkt)
+    sync.fkt(missing, sync.arg);
+}
+
+void ESPKNXIP::__loop_sync()
+{
+  if (!sync.running)
+    return;
+
+  unsigned long now = millis();
+  if ((long)(now - sync.next_send) < 0)
+    return;
+
+  for (; sync.next_item < sync.item_count; ++sync.next_item)
+  {
+    address_t address;
+    if ((sync.done[sync.next_item / 8] & (1 << (sync.next_item % 8))) || !__sync_item_address(sync.next_item, address))
+      continue;
+
+    if (read_request(address, __sync_read_result, this) >= MAX_READ_REQUESTS)
+    {
+      // Read request table is full, try again later
+      sync.next_send = now + SYNC_INTERVAL;
+      return;
+    }
+
+    sync.outstanding++;
+    sync.next_item++;
+    sync.next_send = now + SYNC_INTERVAL;
+    return;
+  }
+
+  // Round complete, wait for all answers or timeouts
+  if (sync.outstanding > 0)
+    return;
+
+  uint16_t missing = 0;
+  for (uint16_t i = 0; i < sync.item_count; ++i)
+  {
+    address_t address;
+    if (!(sync.done[i / 8] & (1 << (i % 8))) && __sync_item_address(i, address))
+      missing++;
+  }
+
+  if (missing == 0 || sync.round >= SYNC_RETRIES)
+  {
+    __sync_finish(missing);
+    return;
+  }
+
+  DEBUG_PRINT(F("Sync retrying missing: "));
+  DEBUG_PRINTLN(missing);
+  sync.round++;
+  sync.next_item = 0;
+  sync.next_send = now + SYNC_INTERVAL;
+}
+
+/**
+ * Returns a value that is stable for this device but differs between devices
+ */
+uint32_t ESPKNXIP::__device_hash(uint32_t salt)
+{
+  // FNV-1a over chip id, physical address and salt
+  uint32_t h = 2166136261u;
+  uint32_t chip = ESP.getChipId();
+  uint8_t in[] = {
+    (uint8_t)(chip >> 24), (uint8_t)(chip >> 16), (uint8_t)(chip >> 8), (uint8_t)chip,
+    physaddr.bytes.high, physaddr.bytes.low,
+    (uint8_t)(salt >> 24), (uint8_t)(salt >> 16), (uint8_t)(salt >> 8), (uint8_t)salt
+  };
+  for (uint8_t i = 0; i < sizeof(in); ++i)
+  {
+    h ^= in[i];
+    h *= 16777619u;
+  }
+  return h;
+}
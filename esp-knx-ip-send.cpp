@@ -14,6 +14,19 @@ void ESPKNXIP::send(address_t const &receiver, knx_command_type_t ct, uint8_t da
 {
 	if (receiver.value == 0)
 	return;
+	__send(receiver, 0x01, KNX_COT_UDP, 0x00, ct, data_len, data);
+}
+
+/**
+ * Builds and sends a single telegram.
+ * For data packets (KNX_COT_UDP, KNX_COT_NDP), apci is the command type and data holds the APDU.
+ * For control packets (KNX_COT_UCD, KNX_COT_NCD), apci is the knx_transport_control_t and no data is sent.
+ */
+void ESPKNXIP::__send(address_t const &receiver, uint8_t dest_addr_type, knx_communication_type_t comm_type, uint8_t seq_number, uint8_t apci, uint8_t data_len, uint8_t *data)
+{
+	bool control = comm_type == KNX_COT_UCD || comm_type == KNX_COT_NCD;
+	if (control)
+	data_len = 0;
 #if SEND_CHECKSUM
 	uint32_t len = 6 + 2 + 8 + data_len + 1; // knx_pkt + cemi_msg + cemi_service + data + checksum
 #else
@@ -22,6 +35,9 @@ void ESPKNXIP::send(address_t const &receiver, knx_command_type_t ct, uint8_t da
 	DEBUG_PRINT(F("Creating packet with len "));
 	DEBUG_PRINTLN(len)
 	uint8_t buf[len];
+#if !DISABLE_MEMORY_STATS
+	__stack_sample(buf);
+#endif
 	knx_ip_pkt_t *knx_pkt = (knx_ip_pkt_t *)buf;
 	knx_pkt->header_len = 0x06;
 	knx_pkt->protocol_version = 0x10;
@@ -37,20 +53,27 @@ void ESPKNXIP::send(address_t const &receiver, knx_command_type_t ct, uint8_t da
 	cemi_data->control_1.bits.system_broadcast = 0x01;
 	cemi_data->control_1.bits.repeat = 0x01;
 	cemi_data->control_1.bits.reserved = 0;
-	cemi_data->control_1.bits.frame_type = 0x01;
+	cemi_data->control_1.bits.frame_type = data_len > 15 ? 0x00 : 0x01; // APDUs longer than 15 bytes need an extended frame
 	cemi_data->control_2.bits.extended_frame_format = 0x00;
 	cemi_data->control_2.bits.hop_count = 0x06;
-	cemi_data->control_2.bits.dest_addr_type = 0x01;
+	cemi_data->control_2.bits.dest_addr_type = dest_addr_type;
 	cemi_data->source = physaddr;
 	cemi_data->destination = receiver;
 	//cemi_data->destination.bytes.high = (area << 3) | line;
 	//cemi_data->destination.bytes.low = member;
 	cemi_data->data_len = data_len;
-	cemi_data->pci.apci = (ct & 0x0C) >> 2;
-	cemi_data->pci.tpci_seq_number = 0x00; // ???
-	cemi_data->pci.tpci_comm_type = KNX_COT_UDP; // ???
-	memcpy(cemi_data->data, data, data_len);
-	cemi_data->data[0] = (cemi_data->data[0] & 0x3F) | ((ct & 0x03) << 6);
+	cemi_data->pci.tpci_seq_number = seq_number;
+	cemi_data->pci.tpci_comm_type = comm_type;
+	if (control)
+	{
+		cemi_data->pci.apci = apci & 0x03;
+	}
+	else
+	{
+		cemi_data->pci.apci = (apci & 0x0C) >> 2;
+		memcpy(cemi_data->data, data, data_len);
+		cemi_data->data[0] = (cemi_data->data[0] & 0x3F) | ((apci & 0x03) << 6);
+	}
 
 #if SEND_CHECKSUM
 	// Calculate checksum, which is just XOR of all bytes
@@ -62,6 +85,13 @@ void ESPKNXIP::send(address_t const &receiver, knx_command_type_t ct, uint8_t da
 	buf[len - 1] = cs;
 #endif
 
+	bool loopback = dest_addr_type == 0x01 && !control && data_len > 0;
+
+	if (loopback && loopback_mode == LOOPBACK_BEFORE_SEND)
+	{
+		__loopback(cemi_data, (knx_command_type_t)apci);
+	}
+
 	DEBUG_PRINT(F("Sending packet:"));
 	for (int i = 0; i < len; ++i)
 	{
@@ -72,7 +102,59 @@ void ESPKNXIP::send(address_t const &receiver, knx_command_type_t ct, uint8_t da
 
 	udp.beginPacketMulticast(MULTICAST_IP, MULTICAST_PORT, WiFi.localIP());
 	udp.write(buf, len);
-	udp.endPacket();
+	if (udp.endPacket())
+		metrics.tx_telegrams++;
+	else
+		metrics.tx_failed++;
+
+	if (loopback && loopback_mode == LOOPBACK_AFTER_SEND)
+	{
+		__loopback(cemi_data, (knx_command_type_t)apci);
+	}
+}
+
+void ESPKNXIP::loopback_set(loopback_mode_t mode)
+{
+	loopback_mode = mode;
+}
+
+/**
+ * Dispatches a telegram we are sending to our own callbacks.
+ * The callbacks get a copy, so changing the data does not change what is sent.
+ */
+void ESPKNXIP::__loopback(cemi_service_t *cemi_data, knx_command_type_t ct)
+{
+	// Sent by a callback we are dispatching to. Dispatching it right away would recurse, so it waits until the callback
+	// returned. Our own telegrams are not dispatched again when they come back from the network, so it must not be lost.
+	if (loopback_depth > 0)
+	{
+		if (loopback_queue_len >= LOOPBACK_QUEUE_SIZE || cemi_data->data_len > LOOPBACK_DATA_LEN)
+		{
+			DEBUG_PRINTLN(F("Loopback queue full, telegram only sent to the bus"));
+			return;
+		}
+		loopback_entry_t &e = loopback_queue[loopback_queue_len++];
+		e.destination = cemi_data->destination;
+		e.ct = ct;
+		e.data_len = cemi_data->data_len;
+		memcpy(e.data, cemi_data->data, e.data_len);
+		e.data[0] &= 0x3F;
+		return;
+	}
+
+	uint8_t data[cemi_data->data_len];
+	memcpy(data, cemi_data->data, cemi_data->data_len);
+	data[0] &= 0x3F;
+	loopback_depth++;
+	__dispatch(cemi_data->destination, ct, cemi_data->data_len, data);
+	// Callbacks of queued telegrams may queue more. The queue is only emptied here, which bounds a callback sending to its own address.
+	for (uint8_t i = 0; i < loopback_queue_len; ++i)
+	{
+		loopback_entry_t &e = loopback_queue[i];
+		__dispatch(e.destination, (knx_command_type_t)e.ct, e.data_len, e.data);
+	}
+	loopback_queue_len = 0;
+	loopback_depth--;
 }
 
 void ESPKNXIP::send_1bit(address_t const &receiver, knx_command_type_t ct, uint8_t bit)
@@ -0,0 +1,420 @@
+/**
+ * esp-knx-ip library for KNX/IP communication on an ESP8266
+ * Author: Nico Weichbrodt <envy>
+ * License: MIT
+ */
+
+#include "esp-knx-ip.h"
+
+/**
+ * Transport layer functions
+ * Implements connection-oriented point-to-point communication for telegrams addressed to our physical address.
+ * Only one connection is possible at a time and the window size is 1, as defined by the KNX standard.
+ */
+
+void ESPKNXIP::__transport_receive(cemi_service_t *cemi_data)
+{
+  address_t src = cemi_data->source;
+  uint8_t seq = cemi_data->pci.tpci_seq_number;
+  bool from_partner = transport.state != TRANSPORT_STATE_CLOSED && transport.partner.value == src.value;
+
+  DEBUG_PRINT(F("TPCI: 0x"));
+  DEBUG_PRINT(cemi_data->pci.tpci_comm_type, 16);
+  DEBUG_PRINT(F(" SEQ: "));
+  DEBUG_PRINTLN(seq);
+
+  switch (cemi_data->pci.tpci_comm_type)
+  {
+    case KNX_COT_UCD:
+      if (cemi_data->pci.apci == KNX_TC_CONNECT)
+      {
+        if (transport.state != TRANSPORT_STATE_CLOSED && !from_partner)
+        {
+          DEBUG_PRINTLN(F("Already connected, rejecting"));
+          __transport_send_control(src, KNX_TC_DISCONNECT, 0);
+          return;
+        }
+        DEBUG_PRINTLN(F("Connected"));
+        transport.state = TRANSPORT_STATE_OPEN_IDLE;
+        transport.partner = src;
+        transport.seq_send = 0;
+        transport.seq_recv = 0;
+        transport.repetitions = 0;
+        transport.deferred = false;
+      }
+      else if (cemi_data->pci.apci == KNX_TC_DISCONNECT)
+      {
+        if (from_partner)
+        {
+          DEBUG_PRINTLN(F("Disconnected"));
+          transport.state = TRANSPORT_STATE_CLOSED;
+        }
+        return;
+      }
+      break;
+    case KNX_COT_NCD:
+      if (!from_partner)
+        return;
+      if (cemi_data->pci.apci == KNX_TC_ACK)
+      {
+        if (transport.state != TRANSPORT_STATE_OPEN_WAIT || seq != transport.seq_send)
+        {
+          __transport_disconnect();
+          return;
+        }
+        transport.seq_send = (transport.seq_send + 1) & 0x0F;
+        transport.state = TRANSPORT_STATE_OPEN_IDLE;
+        if (transport.deferred)
+        {
+          transport.deferred = false;
+          __transport_send_data(transport.deferred_ct, transport.deferred_len, transport.deferred_data);
+        }
+      }
+      else if (cemi_data->pci.apci == KNX_TC_NAK)
+      {
+        if (transport.state != TRANSPORT_STATE_OPEN_WAIT || seq != transport.seq_send || transport.repetitions >= TRANSPORT_MAX_REPETITIONS)
+        {
+          __transport_disconnect();
+          return;
+        }
+        __transport_repeat();
+      }
+      break;
+    case KNX_COT_NDP:
+      if (!from_partner)
+      {
+        __transport_send_control(src, KNX_TC_DISCONNECT, 0);
+        return;
+      }
+      if (seq == transport.seq_recv)
+      {
+        // Also while we wait for our own ACK, only an answer has to wait for it, see __transport_send_data()
+        __transport_send_control(src, KNX_TC_ACK, seq);
+        transport.seq_recv = (transport.seq_recv + 1) & 0x0F;
+        __transport_handle_apdu(cemi_data);
+      }
+      else if (seq == ((transport.seq_recv - 1) & 0x0F))
+      {
+        // Repetition of an already received packet, our ACK got lost
+        __transport_send_control(src, KNX_TC_ACK, seq);
+      }
+      else
+      {
+        __transport_send_control(src, KNX_TC_NAK, seq);
+      }
+      break;
+    default:
+      // Connectionless communication to our individual address is not supported
+      return;
+  }
+
+  transport.last_activity = millis();
+}
+
+void ESPKNXIP::__transport_handle_apdu(cemi_service_t *cemi_data)
+{
+  if (cemi_data->data_len < 1)
+    return;
+
+  knx_command_type_t ct = (knx_command_type_t)(((cemi_data->data[0] & 0xC0) >> 6) | ((cemi_data->pci.apci & 0x03) << 2));
+  uint8_t count = cemi_data->data[0] & 0x3F;
+
+  DEBUG_PRINT(F("APDU CT: 0x"));
+  DEBUG_PRINTLN(ct, 16);
+
+  switch (ct)
+  {
+    case KNX_CT_MEM_READ:
+    {
+      if (cemi_data->data_len < 3)
+        return;
+      uint16_t address = (cemi_data->data[1] << 8) | cemi_data->data[2];
+      if (count > TRANSPORT_MAX_APDU_LEN - 3)
+        count = 0;
+      uint8_t buf[3 + count];
+      for (uint8_t i = 0; i < count; ++i)
+      {
+        if (!__memory_read(address + i, buf[3 + i]))
+        {
+          // A memory answer with count 0 signals an error
+          count = 0;
+          break;
+        }
+      }
+      buf[0] = count;
+      buf[1] = (uint8_t)(address >> 8);
+      buf[2] = (uint8_t)(address & 0x00FF);
+      __transport_send_data(KNX_CT_MEM_ANSWER, 3 + count, buf);
+      break;
+    }
+    case KNX_CT_MEM_WRITE:
+    {
+      if (cemi_data->data_len < 3 + count)
+        return;
+      uint16_t address = (cemi_data->data[1] << 8) | cemi_data->data[2];
+      // Validate the whole range first, so a write is either applied completely or not at all
+      for (uint8_t i = 0; i < count; ++i)
+      {
+        if (!__memory_write(address + i, cemi_data->data[3 + i], true))
+        {
+          DEBUG_PRINTLN(F("Memory write rejected"));
+          return;
+        }
+      }
+      if (address <= MEMORY_ASSIGNMENTS_START && MEMORY_ASSIGNMENTS_START < address + count
+        && !__memory_assignment_count_valid(cemi_data->data[3 + MEMORY_ASSIGNMENTS_START - address], address, count, &cemi_data->data[3]))
+      {
+        DEBUG_PRINTLN(F("Memory write rejected, assignment count includes unwritten entries"));
+        return;
+      }
+      // Allocated before anything is applied, so running out of memory rejects the whole write
+      uint16_t assignments_end = MEMORY_ASSIGNMENTS_START + 1 + MEMORY_MAX_ASSIGNMENTS * 3;
+      if (address + count > MEMORY_ASSIGNMENTS_START + 1 && address < assignments_end)
+      {
+        uint16_t end = address + count < assignments_end ? address + count : assignments_end;
+        if (!__callback_assignments_reserve((end - MEMORY_ASSIGNMENTS_START - 1 + 2) / 3))
+        {
+          DEBUG_PRINTLN(F("Memory write rejected, out of memory"));
+          return;
+        }
+      }
+      __memory_write_range(address, count, &cemi_data->data[3]);
+      break;
+    }
+    default:
+      DEBUG_PRINTLN(F("Unsupported APDU"));
+      break;
+  }
+}
+
+void ESPKNXIP::__transport_send_control(address_t const &receiver, knx_transport_control_t ctrl, uint8_t seq_number)
+{
+  knx_communication_type_t comm_type = (ctrl == KNX_TC_ACK || ctrl == KNX_TC_NAK) ? KNX_COT_NCD : KNX_COT_UCD;
+  __send(receiver, 0x00, comm_type, seq_number, ctrl, 0, nullptr);
+}
+
+/**
+ * Sends a numbered data packet. While the last one is not acknowledged yet, one packet waits for the ACK.
+ */
+void ESPKNXIP::__transport_send_data(knx_command_type_t ct, uint8_t data_len, uint8_t *data)
+{
+  if (transport.state == TRANSPORT_STATE_CLOSED || data_len > TRANSPORT_MAX_APDU_LEN)
+    return;
+
+  if (transport.state == TRANSPORT_STATE_OPEN_WAIT)
+  {
+    if (transport.deferred)
+    {
+      DEBUG_PRINTLN(F("Answer already waiting, dropped"));
+      return;
+    }
+    transport.deferred = true;
+    transport.deferred_ct = ct;
+    transport.deferred_len = data_len;
+    memcpy(transport.deferred_data, data, data_len);
+    return;
+  }
+
+  transport.pending_ct = ct;
+  transport.pending_len = data_len;
+  memcpy(transport.pending_data, data, data_len);
+  transport.repetitions = 0;
+  transport.state = TRANSPORT_STATE_OPEN_WAIT;
+  transport.last_send = millis();
+  __send(transport.partner, 0x00, KNX_COT_NDP, transport.seq_send, ct, transport.pending_len, transport.pending_data);
+}
+
+void ESPKNXIP::__transport_repeat()
+{
+  transport.repetitions++;
+  transport.last_send = millis();
+  __send(transport.partner, 0x00, KNX_COT_NDP, transport.seq_send, transport.pending_ct, transport.pending_len, transport.pending_data);
+}
+
+void ESPKNXIP::__transport_disconnect()
+{
+  if (transport.state == TRANSPORT_STATE_CLOSED)
+    return;
+
+  DEBUG_PRINTLN(F("Closing connection"));
+  __transport_send_control(transport.partner, KNX_TC_DISCONNECT, 0);
+  transport.state = TRANSPORT_STATE_CLOSED;
+}
+
+void ESPKNXIP::__loop_transport()
+{
+  if (transport.state == TRANSPORT_STATE_CLOSED)
+    return;
+
+  unsigned long now = millis();
+  if (now - transport.last_activity >= TRANSPORT_CONNECTION_TIMEOUT)
+  {
+    DEBUG_PRINTLN(F("Connection timed out"));
+    __transport_disconnect();
+    return;
+  }
+
+  if (transport.state == TRANSPORT_STATE_OPEN_WAIT && now - transport.last_send >= TRANSPORT_ACK_TIMEOUT)
+  {
+    if (transport.repetitions >= TRANSPORT_MAX_REPETITIONS)
+    {
+      __transport_disconnect();
+      return;
+    }
+    __transport_repeat();
+  }
+}
+
+/**
+ * Memory functions, see MEMORY_*_START in esp-knx-ip.h for the layout
+ */
+
+bool ESPKNXIP::__memory_read(uint16_t address, uint8_t &val)
+{
+  if (address >= MEMORY_PHYSADDR_START && address < MEMORY_PHYSADDR_START + sizeof(address_t))
+  {
+    val = (address == MEMORY_PHYSADDR_START) ? physaddr.bytes.high : physaddr.bytes.low;
+    return true;
+  }
+
+  if (address >= MEMORY_ASSIGNMENTS_START && address < MEMORY_ASSIGNMENTS_START + 1 + MEMORY_MAX_ASSIGNMENTS * 3)
+  {
+    uint16_t offset = address - MEMORY_ASSIGNMENTS_START;
+    if (offset == 0)
+    {
+      val = registered_callback_assignments < MEMORY_MAX_ASSIGNMENTS ? registered_callback_assignments : MEMORY_MAX_ASSIGNMENTS;
+      return true;
+    }
+    offset -= 1;
+    if (offset / 3 >= callback_assignments_capacity || offset / 3 >= registered_callback_assignments)
+    {
+      // Not allocated or past the count, reads as empty with no callback
+      val = (offset % 3 == 2) ? 0xFF : 0;
+      return true;
+    }
+    callback_assignment_t &assignment = callback_assignments[offset / 3];
+    switch (offset % 3)
+    {
+      case 0: val = assignment.address.bytes.high; break;
+      case 1: val = assignment.address.bytes.low; break;
+      case 2:
+        // Only a live entry whose id does not fit the one byte of the bus layout fails
+        if (assignment.callback_id > 0xFF)
+          return false;
+        val = assignment.callback_id;
+        break;
+    }
+    return true;
+  }
+
+  if (address >= MEMORY_CONFIG_START && address < MEMORY_CONFIG_START + __config_space_used())
+  {
+    val = custom_config_data[address - MEMORY_CONFIG_START];
+    return true;
+  }
+
+  return false;
+}
+
+bool ESPKNXIP::__memory_write(uint16_t address, uint8_t val, bool dry_run)
+{
+  if (address >= MEMORY_ASSIGNMENTS_START && address < MEMORY_ASSIGNMENTS_START + 1 + MEMORY_MAX_ASSIGNMENTS * 3)
+  {
+    uint16_t offset = address - MEMORY_ASSIGNMENTS_START;
+    // The entries a new count makes live are checked by __memory_assignment_count_valid()
+    if (offset == 0)
+    {
+      if (val > MEMORY_MAX_ASSIGNMENTS)
+        return false;
+      if (!dry_run)
+      {
+        if (val > registered_callback_assignments && !__memory_assignment_count_valid(val, 0, 0, nullptr))
+          return false;
+        registered_callback_assignments = val;
+        __eeprom_mark_assignments_dirty(0);
+      }
+      return true;
+    }
+    offset -= 1;
+    if (offset % 3 == 2 && val >= registered_callbacks)
+      return false;
+    if (dry_run)
+      return true;
+    // Allocated by the caller, validation does not allocate
+    if (offset / 3 >= callback_assignments_capacity)
+      return false;
+    callback_assignment_t &assignment = callback_assignments[offset / 3];
+    __eeprom_mark_assignments_dirty(offset / 3);
+    switch (offset % 3)
+    {
+      case 0: assignment.address.bytes.high = val; break;
+      case 1: assignment.address.bytes.low = val; break;
+      case 2: assignment.callback_id = val; break;
+    }
+    return true;
+  }
+
+  if (address >= MEMORY_CONFIG_START && address < MEMORY_CONFIG_START + __config_space_used())
+  {
+    if (dry_run)
+      return true;
+    uint16_t offset = address - MEMORY_CONFIG_START;
+    config_id_t id = __config_find_offset(offset);
+    if (id != (config_id_t)-1)
+      __config_write(id, offset - custom_configs[id].offset, 1, &val);
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * Checks that a new assignment count val only makes entries live that hold a callback, either written before or
+ * in the write of len bytes of data at address. Entries that were never written have the callback id -1.
+ */
+bool ESPKNXIP::__memory_assignment_count_valid(uint8_t val, uint16_t address, uint8_t len, uint8_t const *data)
+{
+  for (uint16_t i = registered_callback_assignments; i < val; ++i)
+  {
+    uint16_t cb = MEMORY_ASSIGNMENTS_START + 1 + i * 3 + 2;
+    // Checked by __memory_write()
+    if (cb >= address && cb < address + len)
+      continue;
+    if (i >= callback_assignments_capacity || callback_assignments[i].callback_id >= registered_callbacks)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Applies a validated write. The bytes of one config are written together, so it is decoded and its
+ * subscriber is notified once with the complete new value. The assignment count is applied last, after
+ * the entries it makes live.
+ */
+void ESPKNXIP::__memory_write_range(uint16_t address, uint8_t len, uint8_t const *data)
+{
+  for (uint8_t i = 0; i < len; )
+  {
+    uint16_t cur = address + i;
+    if (cur == MEMORY_ASSIGNMENTS_START)
+    {
+      i++;
+      continue;
+    }
+    config_id_t id = cur >= MEMORY_CONFIG_START ? __config_find_offset(cur - MEMORY_CONFIG_START) : (config_id_t)-1;
+    if (id == (config_id_t)-1)
+    {
+      __memory_write(cur, data[i], false);
+      i++;
+      continue;
+    }
+    uint8_t offset = cur - MEMORY_CONFIG_START - custom_configs[id].offset;
+    uint8_t run = custom_configs[id].len - offset;
+    if (run > len - i)
+      run = len - i;
+    __config_write(id, offset, run, data + i);
+    i += run;
+  }
+  if (address <= MEMORY_ASSIGNMENTS_START && MEMORY_ASSIGNMENTS_START < address + len)
+    __memory_write(MEMORY_ASSIGNMENTS_START, data[MEMORY_ASSIGNMENTS_START - address], false);
+}
@@ -5,142 +5,280 @@
  */
 
 #include "esp-knx-ip.h"
+#include "esp-knx-ip-assets.h"
+
+/**
+ * ChunkedWriter
+ */
+
+void ChunkedWriter::begin(int code, const __FlashStringHelper *content_type)
+{
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(code, content_type, "");
+}
+
+void ChunkedWriter::end()
+{
+  flush();
+  // An empty chunk ends the response
+  server->sendContent_P(buffer, 0);
+}
+
+void ChunkedWriter::capture(uint8_t *buf, uint16_t size)
+{
+  capture_buffer = buf;
+  capture_size = size;
+  capture_len = 0;
+  capture_paused = false;
+}
+
+void ChunkedWriter::copy_to_capture(const uint8_t *data, size_t size, bool pgm)
+{
+  if (capture_buffer == nullptr || capture_paused)
+    return;
+  if (capture_len + size > capture_size)
+  {
+    // Incomplete output is useless
+    capture_abort();
+    return;
+  }
+  if (pgm)
+    memcpy_P(capture_buffer + capture_len, data, size);
+  else
+    memcpy(capture_buffer + capture_len, data, size);
+  capture_len += size;
+}
+
+size_t ChunkedWriter::write(uint8_t c)
+{
+  if (len == WEB_CHUNK_SIZE)
+    flush();
+  buffer[len++] = c;
+  copy_to_capture(&c, 1, false);
+  return 1;
+}
+
+size_t ChunkedWriter::write(const uint8_t *data, size_t size)
+{
+  copy_to_capture(data, size, false);
+  size_t n = size;
+  while (n > 0)
+  {
+    if (len == WEB_CHUNK_SIZE)
+      flush();
+    size_t part = WEB_CHUNK_SIZE - len < n ? WEB_CHUNK_SIZE - len : n;
+    memcpy(buffer + len, data, part);
+    len += part;
+    data += part;
+    n -= part;
+  }
+  return size;
+}
+
+size_t ChunkedWriter::print(const __FlashStringHelper *str)
+{
+  PGM_P p = (PGM_P)str;
+  size_t size = strlen_P(p);
+  copy_to_capture((const uint8_t *)p, size, true);
+  if (len + size > WEB_CHUNK_SIZE)
+  {
+    flush();
+    if (size > WEB_CHUNK_SIZE)
+    {
+      server->sendContent_P(p, size);
+      return size;
+    }
+  }
+  memcpy_P(buffer + len, p, size);
+  len += size;
+  return size;
+}
+
+void ChunkedWriter::flush()
+{
+  if (len == 0)
+    return;
+  // sendContent_P() reads RAM as well, and unlike sendContent() it needs no String
+  server->sendContent_P(buffer, len);
+  len = 0;
+}
+
+/**
+ * Sends a file of tools/web as stored in flash. The url contains the version of the files, so browsers may keep
+ * them until the firmware changes them. Every browser accepts gzip, so the encoding is not negotiated.
+ */
+void ESPKNXIP::__handle_asset(web_asset_t asset)
+{
+  server->sendHeader(F("Content-Encoding"), F("gzip"));
+  server->sendHeader(F("Cache-Control"), F("public, max-age=31536000, immutable"));
+  switch (asset)
+  {
+    case ASSET_STYLE:
+      server->send_P(200, PSTR(__ASSET_STYLE_CSS_TYPE), (PGM_P)__asset_style_css, sizeof(__asset_style_css));
+      break;
+    case ASSET_SCRIPT:
+      server->send_P(200, PSTR(__ASSET_APP_JS_TYPE), (PGM_P)__asset_app_js, sizeof(__asset_app_js));
+      break;
+    case ASSET_MONITOR_SCRIPT:
+      server->send_P(200, PSTR(__ASSET_MONITOR_JS_TYPE), (PGM_P)__asset_monitor_js, sizeof(__asset_monitor_js));
+      break;
+  }
+}
 
 void ESPKNXIP::__handle_root()
 {
-  String m = F("<html><head><meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1, shrink-to-fit=no'>");
+  // Rendered straight into the response, so the page never has to fit into the heap at once
+  ChunkedWriter m(server);
+  m.begin(200, F("text/html"));
+#if PAGE_CACHE_SIZE > 0
+  if (page_cache_valid && page_cache_version == state_version)
+  {
+    __page_cache_send(m);
+    m.end();
+    return;
+  }
+  __page_cache_begin(m);
+#endif
+  m.print(F("<html><head><meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1, shrink-to-fit=no'>"));
 #if USE_BOOTSTRAP
-  m += F("<link rel='stylesheet' href='https://maxcdn.bootstrapcdn.com/bootstrap/4.0.0/css/bootstrap.min.css' integrity='sha384-Gn5384xqQ1aoWXA+058RXPxPg6fy4IWvTNh0E263XmFcJlSAwiGgFAW/dAiS6JXm' crossorigin='anonymous'>");
-  m += F("<style>.input-group-insert > .input-group-text { border-radius: 0; }</style>");
+  m.print(F("<link rel='stylesheet' href='" __STYLE_PATH "?v=" __ASSETS_VERSION "'>"));
 #endif
-  m += F("</head><body><div class='container-fluid'>");
-  m += F("<h2>ESP KNX</h2>");
+  m.print(F("</head><body><div class='container-fluid'>"));
+  m.print(F("<h2>ESP KNX</h2>"));
 
   // Feedback
 
   if (registered_feedbacks > 0)
   {
-    m += F("<h4>Feedback</h4>");
+    m.print(F("<h4>Feedback</h4>"));
     for (feedback_id_t i = 0; i < registered_feedbacks; ++i)
     {
       if (feedbacks[i].cond && !feedbacks[i].cond())
       {
         continue;
       }
-      m += F("<form action='" __FEEDBACK_PATH "' method='POST'>");
-      m += F("<div class='row'><div class='col-auto'><div class='input-group'>");
-      m += F("<div class='input-group-prepend'><span class='input-group-text'>");
-      m += feedbacks[i].name;
-      m += F("</span></div>");
+      m.print(F("<form action='" __FEEDBACK_PATH "' method='POST'>"));
+      m.print(F("<div class='row'><div class='col-auto'><div class='input-group'>"));
+      m.print(F("<div class='input-group-prepend'><span class='input-group-text'>"));
+      m.print(__string_pool_get(feedbacks[i].name));
+      m.print(F("</span></div>"));
       switch (feedbacks[i].type)
       {
         case FEEDBACK_TYPE_INT:
-          m += F("<span class='input-group-text'>");
-          m += String(*(int32_t *)feedbacks[i].data);
-          m += F("</span>");
+          m.print(F("<span class='input-group-text' id='fb"));
+          m.print(i);
+          m.print(F("'>"));
+          __page_feedback_value(m, i);
+          m.print(F("</span>"));
           break;
         case FEEDBACK_TYPE_FLOAT:
-          m += F("<span class='input-group-text'>");
-          m += String(*(float *)feedbacks[i].data, feedbacks[i].options.float_options.precision);
-          m += F("</span>");
+        {
+          m.print(F("<span class='input-group-text' id='fb"));
+          m.print(i);
+          m.print(F("'>"));
+          __page_feedback_value(m, i);
+          m.print(F("</span>"));
           break;
+        }
         case FEEDBACK_TYPE_BOOL:
-          m += F("<span class='input-group-text'>");
-          m += (*(bool *)feedbacks[i].data) ? F("True") : F("False");
-          m += F("</span>");
+          m.print(F("<span class='input-group-text' id='fb"));
+          m.print(i);
+          m.print(F("'>"));
+          __page_feedback_value(m, i);
+          m.print(F("</span>"));
           break;
         case FEEDBACK_TYPE_ACTION:
-          m += F("<input class='form-control' type='hidden' name='id' value='");
-          m += i;
-          m += F("' /><div class='input-group-append'><button type='submit' class='btn btn-primary'>Do this</button></div>");
+          m.print(F("<input class='form-control' type='hidden' name='id' value='"));
+          m.print(i);
+          m.print(F("' /><div class='input-group-append'><button type='submit' class='btn btn-primary'>Do this</button></div>"));
           break;
       }
-      m += F("</div></div></div>");
-      m += F("</form>");
+      m.print(F("</div></div></div>"));
+      m.print(F("</form>"));
     }
   }
 
   if (registered_callbacks > 0)
-    m += F("<h4>Callbacks</h4>");
+    m.print(F("<h4>Callbacks</h4>"));
 
   if (registered_callback_assignments > 0)
   {
-    for (uint8_t i = 0; i < registered_callback_assignments; ++i)
+    for (callback_assignment_id_t i = 0; i < registered_callback_assignments; ++i)
     {
       if (callbacks[callback_assignments[i].callback_id].cond && !callbacks[callback_assignments[i].callback_id].cond())
       {
         continue;
       }
       address_t &addr = callback_assignments[i].address;
-      m += F("<form action='" __DELETE_PATH "' method='POST'>");
-      m += F("<div class='row'><div class='col-auto'><div class='input-group'>");
-      m += F("<div class='input-group-prepend'><span class='input-group-text'>");
-      m += addr.ga.area;
-      m += F("/");
-      m += addr.ga.line;
-      m += F("/");
-      m += addr.ga.member;
-      m += F("</span>");
-      m += F("<span class='input-group-text'>");
-      m += callbacks[callback_assignments[i].callback_id].name;
-      m += F("</span></div>");
-      m += F("<input class='form-control' type='hidden' name='id' value='");
-      m += i;
-      m += F("' /><div class='input-group-append'><button type='submit' class='btn btn-danger'>Delete</button></div>");
-      m += F("</div></div></div>");
-      m += F("</form>");
+      m.print(F("<form action='" __DELETE_PATH "' method='POST'>"));
+      m.print(F("<div class='row'><div class='col-auto'><div class='input-group'>"));
+      m.print(F("<div class='input-group-prepend'><span class='input-group-text'>"));
+      m.print(addr.ga.area);
+      m.print(F("/"));
+      m.print(addr.ga.line);
+      m.print(F("/"));
+      m.print(addr.ga.member);
+      m.print(F("</span>"));
+      m.print(F("<span class='input-group-text'>"));
+      m.print(__string_pool_get(callbacks[callback_assignments[i].callback_id].name));
+      m.print(F("</span></div>"));
+      m.print(F("<input class='form-control' type='hidden' name='id' value='"));
+      m.print(i);
+      m.print(F("' /><div class='input-group-append'><button type='submit' class='btn btn-danger'>Delete</button></div>"));
+      m.print(F("</div></div></div>"));
+      m.print(F("</form>"));
     }
   }
 
   if (registered_callbacks > 0)
   {
-    m += F("<form action='" __REGISTER_PATH "' method='POST'>");
-    m += F("<div class='row'><div class='col-auto'><div class='input-group'>");
-    m += F("<input class='form-control' type='number' name='area' min='0' max='31'/>");
-    m += F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>");
-    m += F("<input class='form-control' type='number' name='line' min='0' max='7'/>");
-    m += F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>");
-    m += F("<input class='form-control' type='number' name='member' min='0' max='255'/>");
-    m += F("<div class='input-group-insert'><span class='input-group-text'>-&gt;</span></div>");
-    m += F("<select class='form-control' name='cb'>");
+    m.print(F("<form action='" __REGISTER_PATH "' method='POST'>"));
+    m.print(F("<div class='row'><div class='col-auto'><div class='input-group'>"));
+    m.print(F("<input class='form-control' type='number' name='area' min='0' max='31'/>"));
+    m.print(F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>"));
+    m.print(F("<input class='form-control' type='number' name='line' min='0' max='7'/>"));
+    m.print(F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>"));
+    m.print(F("<input class='form-control' type='number' name='member' min='0' max='255'/>"));
+    m.print(F("<div class='input-group-insert'><span class='input-group-text'>-&gt;</span></div>"));
+    m.print(F("<select class='form-control' name='cb'>"));
     for (callback_id_t i = 0; i < registered_callbacks; ++i)
     {
       if (callbacks[i].cond && !callbacks[i].cond())
       {
         continue;
       }
-      m += F("<option value=\"");
-      m += i;
-      m += F("\">");
-      m += callbacks[i].name;
-      m += F("</option>");
+      m.print(F("<option value=\""));
+      m.print(i);
+      m.print(F("\">"));
+      m.print(__string_pool_get(callbacks[i].name));
+      m.print(F("</option>"));
     }
-    m += F("</select>");
-    m += F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Set</button></div>");
-    m += F("</div></div></div>");
-    m += F("</form>");
+    m.print(F("</select>"));
+    m.print(F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Set</button></div>"));
+    m.print(F("</div></div></div>"));
+    m.print(F("</form>"));
   }
 
-  m += F("<h4>Configuration</h4>");
+  m.print(F("<h4>Configuration</h4>"));
 
   // Physical address
-  m += F("<form action='" __PHYS_PATH "' method='POST'>");
-  m += F("<div class='row'><div class='col-auto'><div class='input-group'>");
-  m += F("<div class='input-group-prepend'><span class='input-group-text'>Physical address</span></div>");
-  m += F("<input class='form-control' type='number' name='area' min='0' max='15' value='");
-  m += physaddr.pa.area;
-  m += F("'/>");
-  m += F("<div class='input-group-insert'><span class='input-group-text'>.</span></div>");
-  m += F("<input class='form-control' type='number' name='line' min='0' max='15' value='");
-  m += physaddr.pa.line;
-  m += F("'/>");
-  m += F("<div class='input-group-insert'><span class='input-group-text'>.</span></div>");
-  m += F("<input class='form-control' type='number' name='member' min='0' max='255' value='");
-  m += physaddr.pa.member;
-  m += F("'/>");
-  m += F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Set</button></div>");
-  m += F("</div></div></div>");
-  m += F("</form>");
+  m.print(F("<form action='" __PHYS_PATH "' method='POST'>"));
+  m.print(F("<div class='row'><div class='col-auto'><div class='input-group'>"));
+  m.print(F("<div class='input-group-prepend'><span class='input-group-text'>Physical address</span></div>"));
+  m.print(F("<input class='form-control' type='number' name='area' min='0' max='15' value='"));
+  m.print(physaddr.pa.area);
+  m.print(F("'/>"));
+  m.print(F("<div class='input-group-insert'><span class='input-group-text'>.</span></div>"));
+  m.print(F("<input class='form-control' type='number' name='line' min='0' max='15' value='"));
+  m.print(physaddr.pa.line);
+  m.print(F("'/>"));
+  m.print(F("<div class='input-group-insert'><span class='input-group-text'>.</span></div>"));
+  m.print(F("<input class='form-control' type='number' name='member' min='0' max='255' value='"));
+  m.print(physaddr.pa.member);
+  m.print(F("'/>"));
+  m.print(F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Set</button></div>"));
+  m.print(F("</div></div></div>"));
+  m.print(F("</form>"));
 
   if (registered_configs > 0)
   {
@@ -150,124 +288,417 @@ void ESPKNXIP::__handle_root()
       if (custom_configs[i].cond && !custom_configs[i].cond())
         continue;
 
-      m += F("<form action='" __CONFIG_PATH "' method='POST'>");
-      m += F("<div class='row'><div class='col-auto'><div class='input-group'>");
-      m += F("<div class='input-group-prepend'><span class='input-group-text'>");
-      m += custom_configs[i].name;
-      m += F("</span></div>");
+      m.print(F("<form action='" __CONFIG_PATH "' method='POST'>"));
+      m.print(F("<div class='row'><div class='col-auto'><div class='input-group'>"));
+      m.print(F("<div class='input-group-prepend'><span class='input-group-text'>"));
+      m.print(__string_pool_get(custom_configs[i].name));
+      m.print(F("</span></div>"));
 
       switch (custom_configs[i].type)
       {
         case CONFIG_TYPE_STRING:
-          m += F("<input class='form-control' type='text' name='value' value='");
-          m += config_get_string(i);
-          m += F("' maxlength='");
-          m += custom_configs[i].len - 1; // Subtract \0 byte
-          m += F("'/>");
+          m.print(F("<input class='form-control' type='text' name='value' value='"));
+          m.print(config_get_string_view(i));
+          m.print(F("' maxlength='"));
+          m.print(custom_configs[i].len - 1); // Subtract \0 byte
+          m.print(F("'/>"));
           break;
         case CONFIG_TYPE_INT:
-          m += F("<input class='form-control' type='number' name='value' value='");
-          m += config_get_int(i);
-          m += F("'/>");
+          m.print(F("<input class='form-control' type='number' name='value' value='"));
+          m.print(config_get_int(i));
+          m.print(F("'/>"));
           break;
         case CONFIG_TYPE_BOOL:
-          m += F("<div class='input-group-insert'><span class='input-group-text'>");
-          m += F("<input type='checkbox' name='value' ");
+          m.print(F("<div class='input-group-insert'><span class='input-group-text'>"));
+          m.print(F("<input type='checkbox' name='value' "));
           if (config_get_bool(i))
-            m += F("checked ");
-          m += F("/>");
-          m += F("</span></div>");
+            m.print(F("checked "));
+          m.print(F("/>"));
+          m.print(F("</span></div>"));
           break;
         case CONFIG_TYPE_OPTIONS:
         {
-          m += F("<select class='custom-select' name='value'>");
+          m.print(F("<select class='custom-select' name='value'>"));
           option_entry_t *cur = custom_configs[i].data.options;
           while (cur->name != nullptr)
           {
             if (config_get_options(i) == cur->value)
             {
-              m += F("<option selected value='");
+              m.print(F("<option selected value='"));
             }
             else
             {
-              m += F("<option value='");
+              m.print(F("<option value='"));
             }
-            m += cur->value;
-            m += F("'>");
-            m += String(cur->name);
-            m += F("</option>");
+            m.print(cur->value);
+            m.print(F("'>"));
+            m.print(cur->name);
+            m.print(F("</option>"));
             cur++;
           }
-          m += F("");
-          m += F("</select>");
+          m.print(F(""));
+          m.print(F("</select>"));
           break;
         }
         case CONFIG_TYPE_GA:
           address_t a = config_get_ga(i);
-          m += F("<input class='form-control' type='number' name='area' min='0' max='31' value='");
-          m += a.ga.area;
-          m += F("'/>");
-          m += F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>");
-          m += F("<input class='form-control' type='number' name='line' min='0' max='7' value='");
-          m += a.ga.line;
-          m += F("'/>");
-          m += F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>");
-          m += F("<input class='form-control' type='number' name='member' min='0' max='255' value='");
-          m += a.ga.member;
-          m += F("'/>");
+          m.print(F("<input class='form-control' type='number' name='area' min='0' max='31' value='"));
+          m.print(a.ga.area);
+          m.print(F("'/>"));
+          m.print(F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>"));
+          m.print(F("<input class='form-control' type='number' name='line' min='0' max='7' value='"));
+          m.print(a.ga.line);
+          m.print(F("'/>"));
+          m.print(F("<div class='input-group-insert'><span class='input-group-text'>/</span></div>"));
+          m.print(F("<input class='form-control' type='number' name='member' min='0' max='255' value='"));
+          m.print(a.ga.member);
+          m.print(F("'/>"));
           break;
       }
-      m += F("<input type='hidden' name='id' value='");
-      m += i;
-      m += F("'/>");
-      m += F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Set</button></div>");
-      m += F("</div></div></div>");
-      m += F("</form>");
+      m.print(F("<input type='hidden' name='id' value='"));
+      m.print(i);
+      m.print(F("'/>"));
+      m.print(F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Set</button></div>"));
+      m.print(F("</div></div></div>"));
+      m.print(F("</form>"));
     }
   }
 
-#if !(DISABLE_EEPROM_BUTTONS && DISABLE_RESTORE_BUTTON && DISABLE_REBOOT_BUTTON)
+#if !(DISABLE_EEPROM_BUTTONS && DISABLE_RESTORE_BUTTON && DISABLE_REBOOT_BUTTON && DISABLE_EXPORT_IMPORT && DISABLE_BUS_MONITOR && DISABLE_CALLBACK_TIMING)
   // EEPROM save and restore
-  m += F("<div class='row'>");
+  m.print(F("<div class='row'>"));
   // Save to EEPROM
 #if !DISABLE_EEPROM_BUTTONS
-  m += F("<div class='col-auto'>");
-  m += F("<form action='" __EEPROM_PATH "' method='POST'>");
-  m += F("<input type='hidden' name='mode' value='1'>");
-  m += F("<button type='submit' class='btn btn-success'>Save to EEPROM</button>");
-  m += F("</form>");
-  m += F("</div>");
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<form action='" __EEPROM_PATH "' method='POST'>"));
+  m.print(F("<input type='hidden' name='mode' value='1'>"));
+  m.print(F("<button type='submit' class='btn btn-success'>Save to EEPROM</button>"));
+  m.print(F("</form>"));
+  m.print(F("</div>"));
   // Restore from EEPROM
-  m += F("<div class='col-auto'>");
-  m += F("<form action='" __EEPROM_PATH "' method='POST'>");
-  m += F("<input type='hidden' name='mode' value='2'>");
-  m += F("<button type='submit' class='btn btn-info'>Restore from EEPROM</button>");
-  m += F("</form>");
-  m += F("</div>");
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<form action='" __EEPROM_PATH "' method='POST'>"));
+  m.print(F("<input type='hidden' name='mode' value='2'>"));
+  m.print(F("<button type='submit' class='btn btn-info'>Restore from EEPROM</button>"));
+  m.print(F("</form>"));
+  m.print(F("</div>"));
 #endif
 #if !DISABLE_RESTORE_BUTTON
   // Load Defaults
-  m += F("<div class='col-auto'>");
-  m += F("<form action='" __RESTORE_PATH "' method='POST'>");
-  m += F("<button type='submit' class='btn btn-warning'>Restore defaults</button>");
-  m += F("</form>");
-  m += F("</div>");
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<form action='" __RESTORE_PATH "' method='POST'>"));
+  m.print(F("<button type='submit' class='btn btn-warning'>Restore defaults</button>"));
+  m.print(F("</form>"));
+  m.print(F("</div>"));
+#endif
+#if !DISABLE_EXPORT_IMPORT
+  // Export and import
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<a class='btn btn-secondary' href='" __EXPORT_PATH "'>Export</a>"));
+  m.print(F("</div>"));
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<form action='" __IMPORT_PATH "' method='POST' enctype='multipart/form-data'>"));
+  m.print(F("<div class='input-group'><input class='form-control' type='file' name='config'/>"));
+  m.print(F("<div class='input-group-append'><button type='submit' class='btn btn-secondary'>Import</button></div></div>"));
+  m.print(F("</form>"));
+  m.print(F("</div>"));
+#endif
+#if !DISABLE_BUS_MONITOR
+  // Bus monitor
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<a class='btn btn-secondary' href='" __MONITOR_PATH "'>Bus monitor</a>"));
+  m.print(F("</div>"));
+#endif
+#if !DISABLE_CALLBACK_TIMING
+  // Callback timing
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<a class='btn btn-secondary' href='" __TIMING_PATH "'>Callback timing</a>"));
+  m.print(F("</div>"));
 #endif
 #if !DISABLE_REBOOT_BUTTON
   // Reboot
-  m += F("<div class='col-auto'>");
-  m += F("<form action='" __REBOOT_PATH "' method='POST'>");
-  m += F("<button type='submit' class='btn btn-danger'>Reboot</button>");
-  m += F("</form>");
-  m += F("</div>");
+  m.print(F("<div class='col-auto'>"));
+  m.print(F("<form action='" __REBOOT_PATH "' method='POST'>"));
+  m.print(F("<button type='submit' class='btn btn-danger'>Reboot</button>"));
+  m.print(F("</form>"));
+  m.print(F("</div>"));
 #endif
-  m += F("</div>"); // row
+  m.print(F("</div>")); // row
 #endif
 
   // End of page
-  m += F("</div></body></html>");
-  server->send(200, F("text/html"), m);
+  m.print(F("</div>"));
+#if !DISABLE_EVENTS
+  // Keeps the feedback values current without reloading the page
+  if (registered_feedbacks > 0)
+    m.print(F("<script src='" __SCRIPT_PATH "?v=" __ASSETS_VERSION "' data-events='" __EVENTS_PATH "'></script>"));
+#endif
+  m.print(F("</body></html>"));
+#if PAGE_CACHE_SIZE > 0
+  __page_cache_end(m);
+#endif
+  m.end();
+}
+
+/**
+ * Prints the current value of a feedback. While the page is captured for the cache, a hole is left there instead.
+ */
+void ESPKNXIP::__page_feedback_value(ChunkedWriter &m, feedback_id_t id)
+{
+#if PAGE_CACHE_SIZE > 0
+  if (m.captured_all())
+  {
+    if (page_cache_holes_count < page_cache_holes_capacity)
+    {
+      page_cache_holes[page_cache_holes_count].offset = m.captured();
+      page_cache_holes[page_cache_holes_count].id = id;
+      page_cache_holes_count++;
+    }
+    else
+    {
+      m.capture_abort();
+    }
+  }
+  m.capture_pause(true);
+#endif
+  switch (feedbacks[id].type)
+  {
+    case FEEDBACK_TYPE_INT:
+      m.print(*(int32_t *)feedbacks[id].data);
+      break;
+    case FEEDBACK_TYPE_FLOAT:
+    {
+      // Formatted on the stack, a temporary String would be allocated on every render
+      char buf[33];
+      m.print(dtostrf(*(float *)feedbacks[id].data, 1, feedbacks[id].options.float_options.precision, buf));
+      break;
+    }
+    case FEEDBACK_TYPE_BOOL:
+      m.print((*(bool *)feedbacks[id].data) ? F("True") : F("False"));
+      break;
+    default:
+      break;
+  }
+#if PAGE_CACHE_SIZE > 0
+  m.capture_pause(false);
+#endif
+}
+
+void ESPKNXIP::page_invalidate()
+{
+  state_version++;
+}
+
+#if PAGE_CACHE_SIZE > 0
+/**
+ * Page cache functions
+ * The page is rendered by __handle_root and captured while it is sent. Requests are answered from the cache as long
+ * as state_version is unchanged, so enable conditions are only called when the page is rendered.
+ */
+
+void ESPKNXIP::__page_cache_begin(ChunkedWriter &m)
+{
+  // This version did not fit last time, it will not fit now
+  if (!page_cache_valid && page_cache_version == state_version && page_cache == nullptr)
+    return;
+
+  page_cache_valid = false;
+  page_cache_version = state_version;
+  page_cache_holes_count = 0;
+
+  if (page_cache == nullptr)
+  {
+    page_cache = (uint8_t *)malloc(PAGE_CACHE_SIZE);
+    if (page_cache == nullptr)
+      return;
+  }
+  if (page_cache_holes_capacity < registered_feedbacks)
+  {
+    page_hole_t *holes = (page_hole_t *)realloc(page_cache_holes, registered_feedbacks * sizeof(page_hole_t));
+    if (holes == nullptr)
+      return;
+    page_cache_holes = holes;
+    page_cache_holes_capacity = registered_feedbacks;
+  }
+  m.capture(page_cache, PAGE_CACHE_SIZE);
+}
+
+void ESPKNXIP::__page_cache_end(ChunkedWriter &m)
+{
+  if (m.captured_all() && page_cache_version == state_version)
+  {
+    page_cache_len = m.captured();
+    page_cache_valid = true;
+    return;
+  }
+  if (m.captured_all() || page_cache == nullptr)
+    return; // Changed while rendering or no memory, try again next time
+  DEBUG_PRINTLN(F("Page does not fit into the cache"));
+  // Returned to the heap until the next change, which may make the page smaller
+  free(page_cache);
+  page_cache = nullptr;
+}
+
+void ESPKNXIP::__page_cache_send(ChunkedWriter &m)
+{
+  uint16_t pos = 0;
+  for (feedback_id_t i = 0; i < page_cache_holes_count; ++i)
+  {
+    m.write(page_cache + pos, page_cache_holes[i].offset - pos);
+    __page_feedback_value(m, page_cache_holes[i].id);
+    pos = page_cache_holes[i].offset;
+  }
+  m.write(page_cache + pos, page_cache_len - pos);
+}
+#endif
+
+#if !DISABLE_BUS_MONITOR
+/**
+ * GET shows the monitor page, POST sets the filters or clears the monitor
+ */
+void ESPKNXIP::__handle_monitor()
+{
+  DEBUG_PRINTLN(F("Monitor called"));
+  if (server->method() == HTTP_POST)
+  {
+    if (server->hasArg(F("clear")))
+      monitor_clear();
+    else if (!monitor_set_filter(server->arg(F("ga")), server->arg(F("source"))))
+    {
+      server->send(400, F("text/plain"), F("Invalid filter"));
+      return;
+    }
+    server->sendHeader(F("Location"), F(__MONITOR_PATH));
+    server->send(302);
+    return;
+  }
+
+  ChunkedWriter m(server);
+  m.begin(200, F("text/html"));
+  m.print(F("<html><head><meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1, shrink-to-fit=no'>"));
+#if USE_BOOTSTRAP
+  m.print(F("<link rel='stylesheet' href='" __STYLE_PATH "?v=" __ASSETS_VERSION "'>"));
+#endif
+  m.print(F("</head><body><div class='container-fluid'>"));
+  m.print(F("<h2><a href='" __ROOT_PATH "'>ESP KNX</a> Bus monitor</h2>"));
+
+  // Filter
+  m.print(F("<form action='" __MONITOR_PATH "' method='POST'>"));
+  m.print(F("<div class='row'><div class='col-auto'><div class='input-group'>"));
+  m.print(F("<div class='input-group-prepend'><span class='input-group-text'>Group address</span></div>"));
+  m.print(F("<input class='form-control' type='text' name='ga' placeholder='1/2/3' value='"));
+  __address_filter_print(m, monitor_filter_ga, true);
+  m.print(F("'/>"));
+  m.print(F("<div class='input-group-insert'><span class='input-group-text'>Source</span></div>"));
+  m.print(F("<input class='form-control' type='text' name='source' placeholder='1.1.2' value='"));
+  __address_filter_print(m, monitor_filter_source, false);
+  m.print(F("'/>"));
+  m.print(F("<div class='input-group-append'><button type='submit' class='btn btn-primary'>Filter</button></div>"));
+  m.print(F("</div></div>"));
+  m.print(F("<div class='col-auto'><button type='submit' name='clear' value='1' class='btn btn-warning'>Clear</button></div>"));
+  m.print(F("</div>"));
+  m.print(F("</form>"));
+
+  // Filled and kept current by the script
+  m.print(F("<table class='table'><thead><tr><th>Time (ms)</th><th>Source</th><th>Destination</th><th>Type</th><th>Data</th></tr></thead>"));
+  m.print(F("<tbody id='telegrams'></tbody></table>"));
+  m.print(F("</div>"));
+  m.print(F("<script src='" __MONITOR_SCRIPT_PATH "?v=" __ASSETS_VERSION "' data-api='" __API_MONITOR_PATH "'></script>"));
+  m.print(F("</body></html>"));
+  m.end();
+}
+#endif
+
+#if !DISABLE_CALLBACK_TIMING
+/**
+ * Shows how often each callback took how long, so a callback stalling the loop can be found
+ */
+void ESPKNXIP::__handle_timing()
+{
+  ChunkedWriter m(server);
+  m.begin(200, F("text/html"));
+  m.print(F("<html><head><meta charset='utf-8'><meta name='viewport' content='width=device-width, initial-scale=1, shrink-to-fit=no'>"));
+#if USE_BOOTSTRAP
+  m.print(F("<link rel='stylesheet' href='" __STYLE_PATH "?v=" __ASSETS_VERSION "'>"));
+#endif
+  m.print(F("</head><body><div class='container-fluid'>"));
+  m.print(F("<h2><a href='" __ROOT_PATH "'>ESP KNX</a> Callback timing</h2>"));
+
+  if (slow_callback.time != 0)
+  {
+    m.print(F("<p>Last slow callback: "));
+    m.print(__string_pool_get(callbacks[slow_callback.id].name));
+    m.print(F(" for "));
+    m.print(slow_callback.address.ga.area);
+    m.print('/');
+    m.print(slow_callback.address.ga.line);
+    m.print('/');
+    m.print(slow_callback.address.ga.member);
+    m.print(F(", "));
+    m.print(slow_callback.duration);
+    m.print(F(" us, "));
+    m.print((millis() - slow_callback.time) / 1000);
+    m.print(F(" s ago</p>"));
+  }
+
+  m.print(F("<h4>Loop phases</h4><table class='table'><thead><tr><th>Phase</th><th>Mean (us)</th><th>Max (us)</th><th>Deferred</th></tr></thead><tbody>"));
+  for (uint8_t i = 0; i < LOOP_PHASE_COUNT; ++i)
+  {
+    m.print(F("<tr><td>"));
+    m.print(FPSTR(__loop_phase_name((loop_phase_t)i)));
+    m.print(F("</td><td>"));
+    m.print(loop_phases[i].mean / 16);
+    m.print(F("</td><td>"));
+    m.print(__loop_phase_max((loop_phase_t)i));
+    m.print(F("</td><td>"));
+    m.print(loop_phases[i].deferred);
+    m.print(F("</td></tr>"));
+  }
+  m.print(F("</tbody></table>"));
+
+  // One column per bucket, headed by its upper limit
+  m.print(F("<h4>Callbacks</h4><table class='table'><thead><tr><th>Callback</th><th>Calls</th><th>Slow</th><th>Max (us)</th>"));
+  for (uint8_t b = 0; b < __CALLBACK_TIMING_BUCKETS; ++b)
+  {
+    m.print(F("<th>"));
+    if (b < __CALLBACK_TIMING_BUCKETS - 1)
+    {
+      m.print(F("&le; "));
+      m.print(__callback_timing_limit(b));
+    }
+    else
+    {
+      m.print(F("&gt; "));
+      m.print(__callback_timing_limit(b - 1));
+    }
+    m.print(F(" us</th>"));
+  }
+  m.print(F("</tr></thead><tbody>"));
+  for (callback_id_t i = 0; i < registered_callbacks; ++i)
+  {
+    callback_timing_t &t = callbacks[i].timing;
+    m.print(F("<tr><td>"));
+    m.print(__string_pool_get(callbacks[i].name));
+    m.print(F("</td><td>"));
+    m.print(callbacks[i].calls);
+    m.print(F("</td><td>"));
+    m.print(t.slow);
+    m.print(F("</td><td>"));
+    m.print(t.max);
+    m.print(F("</td>"));
+    for (uint8_t b = 0; b < __CALLBACK_TIMING_BUCKETS; ++b)
+    {
+      m.print(F("<td>"));
+      m.print(t.buckets[b]);
+      m.print(F("</td>"));
+    }
+    m.print(F("</tr>"));
+  }
+  m.print(F("</tbody></table>"));
+  m.print(F("</div></body></html>"));
+  m.end();
 }
+#endif
 
 void ESPKNXIP::__handle_register()
 {
@@ -355,8 +786,10 @@ void ESPKNXIP::__handle_set()
       goto end;
     }
 
-    physaddr.bytes.high = (area << 4) | line;
-    physaddr.bytes.low = member;
+    address_t tmp;
+    tmp.bytes.high = (area << 4) | line;
+    tmp.bytes.low = member;
+    physical_address_set(tmp);
   }
 end:
   server->sendHeader(F("Location"),F(__ROOT_PATH));
@@ -385,7 +818,8 @@ void ESPKNXIP::__handle_config()
       case CONFIG_TYPE_STRING:
       {
         String v = server->arg(F("value"));
-        if (v.length() >= custom_configs[id].len)
+        // len includes the flags byte, the value needs room for the \0
+        if (v.length() >= custom_configs[id].len - sizeof(uint8_t))
           goto end;
         __config_set_flags(id, CONFIG_FLAGS_VALUE_SET);
         __config_set_string(id, v);
@@ -475,7 +909,10 @@ end:
 void ESPKNXIP::__handle_restore()
 {
   DEBUG_PRINTLN(F("Restore called"));
-  memcpy(custom_config_data, custom_config_default_data, MAX_CONFIG_SPACE);
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    __config_set_default(i);
+  }
 end:
   server->sendHeader(F("Location"),F(__ROOT_PATH));
   server->send(302);
@@ -522,3 +959,171 @@ end:
   server->send(302);
 }
 #endif
+
+#if !DISABLE_EXPORT_IMPORT
+void ESPKNXIP::__handle_export()
+{
+  DEBUG_PRINTLN(F("Export called"));
+  bool json = server->arg(F("format")).compareTo(F("json")) == 0;
+
+  ChunkedWriter out(server);
+  if (json)
+  {
+    out.begin(200, F("application/json"));
+    config_export_json(out);
+  }
+  else
+  {
+    server->sendHeader(F("Content-Disposition"), F("attachment; filename=\"knx-config.bin\""));
+    out.begin(200, F("application/octet-stream"));
+    config_export(out);
+  }
+  out.end();
+}
+
+void ESPKNXIP::__handle_import_upload()
+{
+  HTTPUpload &upload = server->upload();
+  switch (upload.status)
+  {
+    case UPLOAD_FILE_START:
+      // An export is never larger than the EEPROM image
+      free(import_buffer);
+      import_buffer = (uint8_t *)malloc(EEPROM_SIZE);
+      import_len = 0;
+      import_overflow = import_buffer == nullptr;
+      break;
+    case UPLOAD_FILE_WRITE:
+      if (import_overflow || import_len + upload.currentSize > EEPROM_SIZE)
+      {
+        import_overflow = true;
+        break;
+      }
+      memcpy(import_buffer + import_len, upload.buf, upload.currentSize);
+      import_len += upload.currentSize;
+      break;
+    case UPLOAD_FILE_ABORTED:
+      import_overflow = true;
+      break;
+    default:
+      break;
+  }
+}
+
+void ESPKNXIP::__handle_import()
+{
+  DEBUG_PRINTLN(F("Import called"));
+  bool ok = import_buffer != nullptr && !import_overflow && config_import(import_buffer, import_len);
+  // A binary export starts with the EEPROM magic, never with '{'
+  bool json = !ok && import_buffer != nullptr && !import_overflow && import_len > 0 && import_buffer[0] == '{';
+  free(import_buffer);
+  import_buffer = nullptr;
+  import_len = 0;
+
+  if (json)
+  {
+    server->send(400, F("text/plain"), F("A JSON export cannot be imported, use the binary export"));
+    return;
+  }
+  if (!ok)
+  {
+    server->send(400, F("text/plain"), F("Invalid configuration"));
+    return;
+  }
+  server->sendHeader(F("Location"),F(__ROOT_PATH));
+  server->send(302);
+}
+#endif
+
+#if !DISABLE_JSON_API
+void ESPKNXIP::__handle_api(api_resource_t resource)
+{
+  DEBUG_PRINTLN(F("API called"));
+  uint32_t etag = state_version;
+  if (resource == API_FEEDBACK)
+    etag = __feedback_hash();
+  else if (resource == API_CALLBACKS)
+    etag ^= metrics.rx_telegrams * 2654435761u; // Timings only change when telegrams are dispatched
+  else if (resource == API_MEMORY)
+    etag ^= metrics.web_requests * 2654435761u; // Every request changes the heap, so this is never the same
+  if (__api_not_modified(etag))
+    return;
+
+  ChunkedWriter out(server);
+  out.begin(200, F("application/json"));
+  switch (resource)
+  {
+    case API_FEEDBACK:
+      __json_feedbacks(out);
+      break;
+    case API_CONFIG:
+      __json_configs(out);
+      break;
+    case API_ASSIGNMENTS:
+      __json_assignments(out);
+      break;
+    case API_PHYSADDR:
+      out.print(F("{\"physical_address\":"));
+      __json_physical_address(out);
+      out.print('}');
+      break;
+    case API_CALLBACKS:
+#if !DISABLE_CALLBACK_TIMING
+      __json_callbacks(out);
+#endif
+      break;
+    case API_MEMORY:
+#if !DISABLE_MEMORY_STATS
+      __json_memory(out);
+#endif
+      break;
+  }
+  out.end();
+}
+
+/**
+ * Sets the ETag header. If the client already has this version, a 304 is sent and true is returned.
+ */
+bool ESPKNXIP::__api_not_modified(uint32_t etag)
+{
+  char tag[11];
+  sprintf_P(tag, PSTR("\"%08x\""), (unsigned int)etag);
+  server->sendHeader(F("ETag"), tag);
+  // Clients have to ask every time, but unchanged answers are only a header
+  server->sendHeader(F("Cache-Control"), F("no-cache"));
+  if (server->header(F("If-None-Match")).equals(tag))
+  {
+    server->send(304);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Feedback values live in variables of the application and can change at any time, so their ETag is a hash of
+ * the current values instead of a version
+ */
+uint32_t ESPKNXIP::__feedback_hash()
+{
+  uint32_t hash = 2166136261u ^ state_version;
+  for (feedback_id_t i = 0; i < registered_feedbacks; ++i)
+  {
+    uint8_t len = 0;
+    switch (feedbacks[i].type)
+    {
+      case FEEDBACK_TYPE_INT: len = sizeof(int32_t); break;
+      case FEEDBACK_TYPE_FLOAT: len = sizeof(float); break;
+      case FEEDBACK_TYPE_BOOL: len = sizeof(bool); break;
+      default: break;
+    }
+    uint8_t const *data = (uint8_t const *)feedbacks[i].data;
+    for (uint8_t j = 0; j < len; ++j)
+    {
+      hash = (hash ^ data[j]) * 16777619u;
+    }
+    // Feedbacks are hidden or shown by their enable condition
+    hash = (hash ^ (feedbacks[i].cond == nullptr || feedbacks[i].cond())) * 16777619u;
+  }
+  return hash;
+}
+#endif
@@ -6,115 +6,682 @@
 
 #include "esp-knx-ip.h"
 
-ESPKNXIP::ESPKNXIP() : server(nullptr), registered_callback_assignments(0), registered_callbacks(0), registered_configs(0), registered_feedbacks(0)
+ESPKNXIP::ESPKNXIP() : server(nullptr), eeprom_dirty(EEPROM_DIRTY_MAGIC), eeprom_assignments_dirty_from(0), loopback_mode(LOOPBACK_DEFAULT), loopback_depth(0), loopback_queue_len(0), registered_callback_assignments(0), callback_assignments_capacity(0), callback_assignments(nullptr), registered_callbacks(0), callbacks_capacity(0), callbacks(nullptr), registered_configs(0), custom_configs_capacity(0), custom_configs(nullptr), custom_config_data_capacity(0), custom_config_data(nullptr), config_index_size(0), config_index(nullptr), callback_index_size(0), callback_index(nullptr), registered_feedbacks(0), feedbacks_capacity(0), feedbacks(nullptr), string_pool_len(0), string_pool_capacity(0), string_pool(nullptr), registered_cyclics(0), next_cyclic(0)
 {
   DEBUG_PRINTLN();
   DEBUG_PRINTLN("ESPKNXIP starting up");
   // Default physical address is 1.1.0
   physaddr.bytes.high = (/*area*/1 << 4) | /*line*/1;
   physaddr.bytes.low = /*member*/0;
-  memset(callback_assignments, 0, MAX_CALLBACK_ASSIGNMENTS * sizeof(callback_assignment_t));
-  memset(callbacks, 0, MAX_CALLBACKS * sizeof(callback_fptr_t));
-  memset(custom_config_data, 0, MAX_CONFIG_SPACE * sizeof(uint8_t));
-  memset(custom_config_default_data, 0, MAX_CONFIG_SPACE * sizeof(uint8_t));
-  memset(custom_configs, 0, MAX_CONFIGS * sizeof(config_t));
+  // Random start, so an ETag from before a reboot does not match by chance
+  state_version = RANDOM_REG32;
+  memset(cyclics, 0, MAX_CYCLICS * sizeof(cyclic_t));
+  memset(read_requests, 0, MAX_READ_REQUESTS * sizeof(read_request_t));
+  memset(&sync, 0, sizeof(sync_state_t));
+  memset(&metrics, 0, sizeof(metrics_t));
+  memset(loop_phases, 0, sizeof(loop_phases));
+  loop_budget = LOOP_BUDGET;
+  loop_dispatch_time = 0;
+  loop_window_end = LOOP_PROFILE_WINDOW;
+  loop_deferred = false;
+#if !DISABLE_CALLBACK_TIMING
+  memset(&slow_callback, 0, sizeof(slow_callback_t));
+#endif
+#if !DISABLE_MEMORY_STATS
+  memory_probes = nullptr;
+  memory_probes_count = 0;
+  memory_probes_capacity = 0;
+  memset(&memory_save, 0, sizeof(memory_probe_t));
+  memory_save.name = PSTR("save");
+  stack_base = 0;
+  stack_max = 0;
+#endif
+  memset(&transport, 0, sizeof(transport_connection_t));
+  memset(&eeprom_stats, 0, sizeof(eeprom_stats_t));
+  // Without a valid slot, the first save goes to slot 1 and leaves the EEPROM sector untouched
+  eeprom_slot = 0;
+  eeprom_generation = 0;
+#if USE_CONFIG_JOURNAL
+  journal_valid = false;
+  journal_sector = JOURNAL_SECTORS - 1;
+  journal_sequence = 0;
+  journal_offset = 0;
+#endif
+#if !DISABLE_EVENTS
+  event_next_tick = 0;
+  event_snapshot = nullptr;
+#endif
+#if !DISABLE_BUS_MONITOR
+  monitor_next = 0;
+  memset(&monitor_filter_ga, 0, sizeof(address_filter_t));
+  memset(&monitor_filter_source, 0, sizeof(address_filter_t));
+#endif
+#if PAGE_CACHE_SIZE > 0
+  page_cache = nullptr;
+  page_cache_len = 0;
+  page_cache_holes = nullptr;
+  page_cache_holes_count = 0;
+  page_cache_holes_capacity = 0;
+  page_cache_version = 0;
+  page_cache_valid = false;
+#endif
+#if !DISABLE_EXPORT_IMPORT
+  import_buffer = nullptr;
+  import_len = 0;
+  import_overflow = false;
+#endif
 }
 
+extern "C" uint32_t _SPIFFS_start;
+extern "C" uint32_t _SPIFFS_end;
+
 void ESPKNXIP::load()
 {
-  memcpy(custom_config_default_data, custom_config_data, MAX_CONFIG_SPACE);
+  __storage_index_build();
+#if USE_CONFIG_JOURNAL
+  if (!__journal_usable())
+  {
+    DEBUG_PRINTLN("Journal sectors are part of SPIFFS, saving to the EEPROM instead");
+    EEPROM.begin(EEPROM_SIZE);
+  }
+#else
   EEPROM.begin(EEPROM_SIZE);
+#endif
   restore_from_eeprom();
+
+  // Registration is done, so the registries are shrunk to their exact size
+  __registry_shrink((void **)&callbacks, callbacks_capacity, registered_callbacks, sizeof(callback_t));
+  __registry_shrink((void **)&custom_configs, custom_configs_capacity, registered_configs, sizeof(config_t));
+  __registry_shrink((void **)&custom_config_data, custom_config_data_capacity, __config_space_used(), sizeof(uint8_t));
+  __registry_shrink((void **)&feedbacks, feedbacks_capacity, registered_feedbacks, sizeof(feedback_t));
+  __registry_shrink((void **)&callback_assignments, callback_assignments_capacity, registered_callback_assignments, sizeof(callback_assignment_t));
+  __registry_shrink((void **)&string_pool, string_pool_capacity, string_pool_len, sizeof(char));
+}
+
+/**
+ * Registry functions
+ * Registered items are kept in contiguous blocks on the heap. A block doubles its size when it is full, up to
+ * the MAX_ limit, and load() shrinks it to the number of registered items.
+ */
+
+bool ESPKNXIP::__registry_reserve(void **items, uint16_t &capacity, uint32_t needed, size_t item_size, uint16_t limit)
+{
+  if (needed <= capacity)
+    return true;
+  if (needed > limit)
+    return false;
+
+  uint32_t new_capacity = capacity == 0 ? REGISTRY_INITIAL_CAPACITY : capacity * 2;
+  if (new_capacity < needed)
+    new_capacity = needed;
+  if (new_capacity > limit)
+    new_capacity = limit;
+
+  void *p = realloc(*items, new_capacity * item_size);
+  if (p == nullptr)
+    return false;
+
+  memset((uint8_t *)p + capacity * item_size, 0, (new_capacity - capacity) * item_size);
+  *items = p;
+  capacity = new_capacity;
+  return true;
+}
+
+void ESPKNXIP::__registry_shrink(void **items, uint16_t &capacity, uint16_t count, size_t item_size)
+{
+  if (count == capacity)
+    return;
+
+  if (count == 0)
+  {
+    free(*items);
+    *items = nullptr;
+    capacity = 0;
+    return;
+  }
+
+  void *p = realloc(*items, count * item_size);
+  if (p == nullptr)
+    return;
+  *items = p;
+  capacity = count;
+}
+
+bool ESPKNXIP::__callback_assignments_reserve(uint32_t needed)
+{
+  uint16_t capacity = callback_assignments_capacity;
+  if (!__registry_reserve((void **)&callback_assignments, callback_assignments_capacity, needed, sizeof(callback_assignment_t), MAX_CALLBACK_ASSIGNMENTS))
+    return false;
+  // Entries after registered_callback_assignments have no callback until one is written, see __memory_assignment_count_valid()
+  for (uint16_t i = capacity; i < callback_assignments_capacity; ++i)
+  {
+    callback_assignments[i].callback_id = -1;
+  }
+  return true;
 }
 
 void ESPKNXIP::start(ESP8266WebServer *srv)
 {
   server = srv;
-  __start();
+  __start(false);
 }
 
 void ESPKNXIP::start()
 {
   server = new ESP8266WebServer(80);
-  __start();
+  __start(true);
 }
 
-void ESPKNXIP::__start()
+/**
+ * Registers a handler with the webserver, counts its requests and records the heap around them
+ */
+void ESPKNXIP::__web_on(const __FlashStringHelper *uri, HTTPMethod method, ESP8266WebServer::THandlerFunction fn, ESP8266WebServer::THandlerFunction upload)
+{
+#if !DISABLE_MEMORY_STATS
+  // Routes are only registered in __start(), the probes never move afterwards
+  uint16_t probe = memory_probes_count;
+  if (__registry_reserve((void **)&memory_probes, memory_probes_capacity, probe + 1, sizeof(memory_probe_t), 0xFFFF))
+  {
+    memory_probes[probe].name = (PGM_P)uri;
+    memory_probes_count++;
+  }
+  ESP8266WebServer::THandlerFunction counted = [this, fn, probe](){
+    metrics.web_requests++;
+    if (probe < memory_probes_count)
+      __memory_probe_begin(memory_probes[probe]);
+    fn();
+    if (probe < memory_probes_count)
+      __memory_probe_end(memory_probes[probe]);
+  };
+#else
+  ESP8266WebServer::THandlerFunction counted = [this, fn](){
+    metrics.web_requests++;
+    fn();
+  };
+#endif
+  if (upload)
+    server->on(uri, method, counted, upload);
+  else
+    server->on(uri, method, counted);
+}
+
+void ESPKNXIP::__start(bool own_server)
 {
   if (server != nullptr)
   {
-    server->on(ROOT_PREFIX, [this](){
+    __web_on(F(ROOT_PREFIX), HTTP_ANY, [this](){
       __handle_root();
     });
-    server->on(__ROOT_PATH, [this](){
+    __web_on(F(__ROOT_PATH), HTTP_ANY, [this](){
       __handle_root();
     });
-    server->on(__REGISTER_PATH, [this](){
+#if USE_BOOTSTRAP
+    __web_on(F(__STYLE_PATH), HTTP_ANY, [this](){
+      __handle_asset(ASSET_STYLE);
+    });
+#endif
+#if !DISABLE_EVENTS
+    __web_on(F(__SCRIPT_PATH), HTTP_ANY, [this](){
+      __handle_asset(ASSET_SCRIPT);
+    });
+#endif
+#if !DISABLE_BUS_MONITOR
+    __web_on(F(__MONITOR_SCRIPT_PATH), HTTP_ANY, [this](){
+      __handle_asset(ASSET_MONITOR_SCRIPT);
+    });
+    __web_on(F(__MONITOR_PATH), HTTP_ANY, [this](){
+      __handle_monitor();
+    });
+    __web_on(F(__API_MONITOR_PATH), HTTP_ANY, [this](){
+      __handle_monitor_api();
+    });
+#endif
+    __web_on(F(__REGISTER_PATH), HTTP_ANY, [this](){
       __handle_register();
     });
-    server->on(__DELETE_PATH, [this](){
+    __web_on(F(__DELETE_PATH), HTTP_ANY, [this](){
       __handle_delete();
     });
-    server->on(__PHYS_PATH, [this](){
+    __web_on(F(__PHYS_PATH), HTTP_ANY, [this](){
       __handle_set();
     });
 #if !DISABLE_EEPROM_BUTTONS
-    server->on(__EEPROM_PATH, [this](){
+    __web_on(F(__EEPROM_PATH), HTTP_ANY, [this](){
       __handle_eeprom();
     });
 #endif
-    server->on(__CONFIG_PATH, [this](){
+    __web_on(F(__CONFIG_PATH), HTTP_ANY, [this](){
       __handle_config();
     });
-    server->on(__FEEDBACK_PATH, [this](){
+    __web_on(F(__FEEDBACK_PATH), HTTP_ANY, [this](){
       __handle_feedback();
     });
 #if !DISABLE_RESTORE_BUTTON
-    server->on(__RESTORE_PATH, [this](){
+    __web_on(F(__RESTORE_PATH), HTTP_ANY, [this](){
       __handle_restore();
     });
 #endif
 #if !DISABLE_REBOOT_BUTTON
-    server->on(__REBOOT_PATH, [this](){
+    __web_on(F(__REBOOT_PATH), HTTP_ANY, [this](){
       __handle_reboot();
     });
+#endif
+#if !DISABLE_EXPORT_IMPORT
+    __web_on(F(__EXPORT_PATH), HTTP_ANY, [this](){
+      __handle_export();
+    });
+    __web_on(F(__IMPORT_PATH), HTTP_POST, [this](){
+      __handle_import();
+    }, [this](){
+      __handle_import_upload();
+    });
+#endif
+#if !DISABLE_EVENTS
+    __web_on(F(__EVENTS_PATH), HTTP_ANY, [this](){
+      __handle_events();
+    });
+#endif
+#if !DISABLE_CALLBACK_TIMING
+    __web_on(F(__TIMING_PATH), HTTP_ANY, [this](){
+      __handle_timing();
+    });
+#endif
+#if !DISABLE_METRICS
+    __web_on(F(__METRICS_PATH), HTTP_ANY, [this](){
+      __handle_metrics();
+    });
+#endif
+#if !DISABLE_JSON_API
+    __web_on(F(__API_FEEDBACK_PATH), HTTP_ANY, [this](){
+      __handle_api(API_FEEDBACK);
+    });
+    __web_on(F(__API_CONFIG_PATH), HTTP_ANY, [this](){
+      __handle_api(API_CONFIG);
+    });
+    __web_on(F(__API_ASSIGNMENTS_PATH), HTTP_ANY, [this](){
+      __handle_api(API_ASSIGNMENTS);
+    });
+    __web_on(F(__API_PHYSADDR_PATH), HTTP_ANY, [this](){
+      __handle_api(API_PHYSADDR);
+    });
+#if !DISABLE_CALLBACK_TIMING
+    __web_on(F(__API_CALLBACKS_PATH), HTTP_ANY, [this](){
+      __handle_api(API_CALLBACKS);
+    });
+#endif
+#if !DISABLE_MEMORY_STATS
+    __web_on(F(__API_MEMORY_PATH), HTTP_ANY, [this](){
+      __handle_api(API_MEMORY);
+    });
+#endif
+    // collectHeaders() replaces the headers collected so far, the application collects them on its own server
+    if (own_server)
+    {
+      const char *headers[] = {"If-None-Match"};
+      server->collectHeaders(headers, 1);
+    }
 #endif
     server->begin();
   }
 
   udp.beginMulticast(WiFi.localIP(),  MULTICAST_IP, MULTICAST_PORT);
+
+  sync_start();
 }
 
 void ESPKNXIP::save_to_eeprom()
+{
+  eeprom_stats.saves++;
+#if !DISABLE_MEMORY_STATS
+  __memory_probe_begin(memory_save);
+#endif
+#if USE_CONFIG_JOURNAL
+  if (__journal_usable())
+    __journal_save();
+  else
+    __eeprom_save();
+#else
+  __eeprom_save();
+#endif
+#if !DISABLE_MEMORY_STATS
+  __memory_probe_end(memory_save);
+#endif
+}
+
+void ESPKNXIP::restore_from_eeprom()
+{
+  unsigned long start = micros();
+#if USE_CONFIG_JOURNAL
+  if (__journal_usable())
+    __journal_restore();
+  else
+    __eeprom_restore();
+#else
+  __eeprom_restore();
+#endif
+  eeprom_stats.last_restore_time = micros() - start;
+  state_version++;
+}
+
+/**
+ * Writes the EEPROM image, see eeprom_record_tag_t for the format. Only bytes that differ from the EEPROM
+ * content are written and the commit is skipped if nothing changed. With config slots, a commit always writes
+ * the whole image.
+ */
+void ESPKNXIP::__eeprom_save()
 {
   uint32_t address = 0;
+  eeprom_stats.last_bytes_written = 0;
+
   uint64_t magic = EEPROM_MAGIC;
-  EEPROM.put(address, magic);
-  address += sizeof(uint64_t);
-  EEPROM.put(address++, registered_callback_assignments);
-  for (uint8_t i = 0; i < MAX_CALLBACK_ASSIGNMENTS; ++i)
+  for (uint8_t i = 0; i < sizeof(uint64_t); ++i)
+  {
+    __eeprom_update(address++, ((uint8_t *)&magic)[i]);
+  }
+
+  __eeprom_write_record(address, EEPROM_RECORD_PHYSADDR, 0, sizeof(address_t), physaddr.array);
+
+  for (callback_assignment_id_t i = 0; i < registered_callback_assignments; ++i)
   {
-    EEPROM.put(address, callback_assignments[i].address);
-    address += sizeof(address_t);
+    uint8_t ga[] = {callback_assignments[i].address.bytes.high, callback_assignments[i].address.bytes.low};
+    if (!__eeprom_write_record(address, EEPROM_RECORD_ASSIGNMENT, callbacks[callback_assignments[i].callback_id].key, sizeof(ga), ga))
+    {
+      DEBUG_PRINTLN("EEPROM full, not all assignments saved");
+      break;
+    }
   }
-  for (uint8_t i = 0; i < MAX_CALLBACK_ASSIGNMENTS; ++i)
+
+  for (config_id_t i = 0; i < registered_configs; ++i)
   {
-    EEPROM.put(address, callback_assignments[i].callback_id);
-    address += sizeof(callback_id_t);
+    if (!__eeprom_write_record(address, EEPROM_RECORD_CONFIG, custom_configs[i].key, custom_configs[i].len, &custom_config_data[custom_configs[i].offset]))
+    {
+      DEBUG_PRINTLN("EEPROM full, not all configs saved");
+      break;
+    }
+  }
+
+  __eeprom_update(address, EEPROM_RECORD_END);
+
+  bool slots = __eeprom_slots_usable();
+  // A missing or failed slot write has to be done, even if the buffer is unchanged
+  if (eeprom_stats.last_bytes_written == 0 && !(slots && (eeprom_dirty & EEPROM_DIRTY_MAGIC)))
+  {
+    DEBUG_PRINTLN("Nothing changed, not writing to EEPROM");
+    eeprom_stats.last_commit_time = 0;
+    __eeprom_mark_clean();
+    return;
   }
-  EEPROM.put(address, physaddr);
-  address += sizeof(address_t);
 
-  EEPROM.put(address, custom_config_data);
-  address += sizeof(custom_config_data);
+  unsigned long start = micros();
+  if (slots)
+  {
+    if (!__eeprom_slot_commit(address + 1))
+    {
+      DEBUG_PRINTLN("Writing config slot failed");
+      eeprom_dirty |= EEPROM_DIRTY_MAGIC;
+      return;
+    }
+    // Whole image and header are written to flash, not only the changed bytes
+    eeprom_stats.last_bytes_written = sizeof(eeprom_slot_t) + ((address + 1 + 3) & ~3);
+  }
+  else
+  {
+    EEPROM.commit();
+  }
+  eeprom_stats.last_commit_time = micros() - start;
+  eeprom_stats.commits++;
+  eeprom_stats.bytes_written += eeprom_stats.last_bytes_written;
+  __eeprom_mark_clean();
+
+  DEBUG_PRINT("Wrote ");
+  DEBUG_PRINT(eeprom_stats.last_bytes_written);
+  DEBUG_PRINT(" bytes to EEPROM in ");
+  DEBUG_PRINT(eeprom_stats.last_commit_time);
+  DEBUG_PRINTLN("us");
+}
 
-  EEPROM.commit();
-  DEBUG_PRINT("Wrote to EEPROM: 0x");
-  DEBUG_PRINTLN(address, HEX);
+uint32_t ESPKNXIP::__eeprom_sector()
+{
+  // Same calculation as the EEPROM library uses for its sector
+  return ((uintptr_t)&_SPIFFS_end - 0x40200000) / SPI_FLASH_SEC_SIZE;
 }
 
-void ESPKNXIP::restore_from_eeprom()
+/**
+ * Slot 1 is the sector below the EEPROM sector, which belongs to SPIFFS unless the flash layout has none.
+ * Saving there would corrupt the file system, so it is only used if it is free or USE_CONFIG_SLOTS is 2.
+ */
+bool ESPKNXIP::__eeprom_slots_usable()
 {
+#if USE_CONFIG_SLOTS == 2
+  return true;
+#elif USE_CONFIG_SLOTS
+  return __eeprom_slot_address(1) < (uintptr_t)&_SPIFFS_start - 0x40200000;
+#else
+  return false;
+#endif
+}
+
+/**
+ * The journal sectors are the last JOURNAL_SECTORS sectors of the SPIFFS area, the same check as for the slots applies.
+ * Without them, the config is saved to the EEPROM.
+ */
+bool ESPKNXIP::__journal_usable()
+{
+#if USE_CONFIG_JOURNAL == 2
+  return true;
+#elif USE_CONFIG_JOURNAL
+  // The highest journal sector is the one right below the EEPROM sector
+  return (__eeprom_sector() - 1) * SPI_FLASH_SEC_SIZE < (uintptr_t)&_SPIFFS_start - 0x40200000;
+#else
+  return false;
+#endif
+}
+
+uint32_t ESPKNXIP::__eeprom_slot_address(uint8_t slot)
+{
+  return (__eeprom_sector() - slot) * SPI_FLASH_SEC_SIZE;
+}
+
+/**
+ * Writes the first len bytes of the EEPROM buffer to the slot not holding the last save and makes it the current one
+ */
+bool ESPKNXIP::__eeprom_slot_commit(uint16_t len)
+{
+  uint8_t slot = eeprom_slot ^ 1;
+  uint32_t address = __eeprom_slot_address(slot);
+  uint8_t *data = EEPROM.getDataPtr();
+  eeprom_slot_t header = {EEPROM_SLOT_MAGIC, eeprom_generation + 1, len, __crc16(data, len)};
+
+  if (!ESP.flashEraseSector(address / SPI_FLASH_SEC_SIZE))
+    return false;
+  // Until the header is written, restore still picks the other slot
+  if (!ESP.flashWrite(address + sizeof(eeprom_slot_t), (uint32_t *)data, (len + 3) & ~3))
+    return false;
+  if (!ESP.flashWrite(address, (uint32_t *)&header, sizeof(eeprom_slot_t)))
+    return false;
+
+  eeprom_slot = slot;
+  eeprom_generation = header.generation;
+  return true;
+}
+
+/**
+ * Reads the image of a slot into the EEPROM buffer and checks its CRC
+ */
+bool ESPKNXIP::__eeprom_slot_read(uint8_t slot, eeprom_slot_t const &header)
+{
+  if (header.magic != EEPROM_SLOT_MAGIC || header.len > EEPROM_SIZE)
+    return false;
+
+  uint8_t *data = EEPROM.getDataPtr();
+  if (!ESP.flashRead(__eeprom_slot_address(slot) + sizeof(eeprom_slot_t), (uint32_t *)data, (header.len + 3) & ~3))
+    return false;
+
+  return __crc16(data, header.len) == header.crc;
+}
+
+/**
+ * Appends a record at address, leaving room for the end tag. Returns false if it does not fit.
+ */
+bool ESPKNXIP::__eeprom_write_record(uint32_t &address, eeprom_record_tag_t tag, uint32_t key, uint8_t len, uint8_t const *data)
+{
+  if (address + EEPROM_RECORD_HEADER_SIZE + len + 1 > EEPROM_SIZE)
+    return false;
+
+  __eeprom_update(address++, tag);
+  __eeprom_update(address++, len);
+  for (uint8_t i = 0; i < sizeof(uint32_t); ++i)
+  {
+    __eeprom_update(address++, (uint8_t)(key >> (i * 8)));
+  }
+  for (uint8_t i = 0; i < len; ++i)
+  {
+    __eeprom_update(address++, data[i]);
+  }
+  return true;
+}
+
+void ESPKNXIP::__eeprom_update(uint32_t address, uint8_t val)
+{
+  if (EEPROM.read(address) == val)
+    return;
+
+  EEPROM.write(address, val);
+  eeprom_stats.last_bytes_written++;
+}
+
+eeprom_stats_t ESPKNXIP::eeprom_stats_get()
+{
+  return eeprom_stats;
+}
+
+/**
+ * Prints the RAM used by the registered items and the string pool, and what is saved compared to fixed arrays of String names
+ */
+void ESPKNXIP::memory_report(Print &out)
+{
+  uint16_t flash_entries = 0;
+  uint16_t ram_entries = 0;
+  uint32_t flash_bytes = 0;
+  for (uint16_t i = 0; i < string_pool_len; )
+  {
+    if (string_pool[i] == STRING_POOL_FLASH)
+    {
+      flash_entries++;
+      flash_bytes += strlen_P((PGM_P)__string_pool_get(i)) + 1;
+      i += 1 + sizeof(PGM_P);
+    }
+    else
+    {
+      ram_entries++;
+      i += strlen(&string_pool[i]) + 1;
+    }
+  }
+  uint16_t items = registered_configs + registered_callbacks + registered_feedbacks;
+
+  out.println(F("Memory report"));
+  out.printf_P(PSTR("Configs:   %u of %u allocated, %u bytes each, %u of %u bytes of data\n"), registered_configs, custom_configs_capacity, sizeof(config_t), __config_space_used(), custom_config_data_capacity);
+  out.printf_P(PSTR("Callbacks: %u of %u allocated, %u bytes each\n"), registered_callbacks, callbacks_capacity, sizeof(callback_t));
+  out.printf_P(PSTR("Feedbacks: %u of %u allocated, %u bytes each\n"), registered_feedbacks, feedbacks_capacity, sizeof(feedback_t));
+  out.printf_P(PSTR("Assignments: %u of %u allocated, %u bytes each\n"), registered_callback_assignments, callback_assignments_capacity, sizeof(callback_assignment_t));
+  out.printf_P(PSTR("Strings:   %u bytes pool (%u allocated), %u in flash (%u bytes), %u in RAM, %u items\n"), string_pool_len, string_pool_capacity, flash_entries, flash_bytes, ram_entries, items);
+  // The layout this replaced: arrays of MAX_ items with String names (12 bytes) and 8-bit ids, and a second buffer of
+  // MAX_CONFIG_SPACE bytes for the defaults. Its item sizes on the ESP8266 were config_t 28 (type, name, offset, len,
+  // cond, options), callback_t 24 (fkt, cond, arg, name), feedback_t 28 (type, name, cond, data, options) and
+  // callback_assignment_t 4 bytes. Names of flash strings were copied to the heap in addition.
+  uint32_t fixed = MAX_CONFIGS * 28 + 2 * MAX_CONFIG_SPACE + MAX_CALLBACKS * 24 + MAX_FEEDBACKS * 28 + MAX_CALLBACK_ASSIGNMENTS * 4;
+  uint32_t allocated = custom_configs_capacity * sizeof(config_t) + custom_config_data_capacity + callbacks_capacity * sizeof(callback_t) + feedbacks_capacity * sizeof(feedback_t) + callback_assignments_capacity * sizeof(callback_assignment_t) + string_pool_capacity;
+  out.printf_P(PSTR("Saved:     %u bytes of registries and names compared to fixed arrays with String names, %u bytes of names kept in flash\n"),
+    fixed > allocated ? fixed - allocated : 0, flash_bytes);
+  out.printf_P(PSTR("Free heap: %u bytes\n"), ESP.getFreeHeap());
+#if !DISABLE_MEMORY_STATS
+#if __CORE_HAS_HEAP_STATS
+  out.printf_P(PSTR("Stack:     %u bytes deepest in loop(), %u bytes never used\n"), stack_max, ESP.getFreeContStack());
+#else
+  out.printf_P(PSTR("Stack:     %u bytes deepest in loop()\n"), stack_max);
+#endif
+  __memory_probe_print(out, memory_save);
+  for (uint16_t i = 0; i < memory_probes_count; ++i)
+  {
+    __memory_probe_print(out, memory_probes[i]);
+  }
+#endif
+}
+
+void ESPKNXIP::__eeprom_mark_all_dirty()
+{
+  eeprom_dirty = EEPROM_DIRTY_MAGIC | EEPROM_DIRTY_PHYSADDR;
+  eeprom_assignments_dirty_from = 0;
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    custom_configs[i].dirty = true;
+  }
+}
+
+void ESPKNXIP::__eeprom_mark_clean()
+{
+  eeprom_dirty = EEPROM_DIRTY_NONE;
+  eeprom_assignments_dirty_from = MAX_CALLBACK_ASSIGNMENTS;
+  for (config_id_t i = 0; i < registered_configs; ++i)
+  {
+    custom_configs[i].dirty = false;
+  }
+}
+
+void ESPKNXIP::__eeprom_mark_assignments_dirty(callback_assignment_id_t from)
+{
+  if (from < eeprom_assignments_dirty_from)
+    eeprom_assignments_dirty_from = from;
+  state_version++;
+}
+
+void ESPKNXIP::__eeprom_restore()
+{
+  // Without slots, the EEPROM library already read the EEPROM sector into its buffer
+  eeprom_slot_t headers[2] = {};
+  if (__eeprom_slots_usable())
+  {
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+      ESP.flashRead(__eeprom_slot_address(i), (uint32_t *)&headers[i], sizeof(eeprom_slot_t));
+    }
+  }
+#if USE_CONFIG_SLOTS
+  else
+  {
+    DEBUG_PRINTLN("Config slot 1 is part of SPIFFS, saving to the EEPROM sector only");
+  }
+#endif
+
+  // Try the newest slot first and fall back to the other one if its image is torn
+  uint8_t newest = (int32_t)(headers[1].generation - headers[0].generation) > 0 ? 1 : 0;
+  if (headers[newest].magic != EEPROM_SLOT_MAGIC)
+    newest ^= 1;
+  bool found = false;
+  for (uint8_t i = 0; i < 2 && !found; ++i)
+  {
+    uint8_t slot = newest ^ i;
+    if (__eeprom_slot_read(slot, headers[slot]))
+    {
+      found = true;
+      eeprom_slot = slot;
+      eeprom_generation = headers[slot].generation;
+    }
+    else if (headers[slot].magic == EEPROM_SLOT_MAGIC)
+    {
+      DEBUG_PRINT("Config slot ");
+      DEBUG_PRINT(slot);
+      DEBUG_PRINTLN(" is torn");
+    }
+  }
+  if (!found && (headers[0].magic == EEPROM_SLOT_MAGIC || headers[1].magic == EEPROM_SLOT_MAGIC))
+  {
+    DEBUG_PRINTLN("No valid config slot, aborting restore.");
+    __eeprom_mark_all_dirty();
+    return;
+  }
+  // Without any slot, the EEPROM buffer still holds what the EEPROM library read from its sector before slots were used
+
   uint32_t address = 0;
   uint64_t magic = 0;
   EEPROM.get(address, magic);
@@ -129,50 +696,294 @@ void ESPKNXIP::restore_from_eeprom()
     DEBUG_PRINT((unsigned long)(magic >> 32), HEX);
     DEBUG_PRINT(" 0x");
     DEBUG_PRINTLN((unsigned long)magic, HEX);
+    __eeprom_mark_all_dirty();
     return;
   }
   address += sizeof(uint64_t);
-  EEPROM.get(address++, registered_callback_assignments);
-  for (uint8_t i = 0; i < MAX_CALLBACK_ASSIGNMENTS; ++i)
-  {
-    EEPROM.get(address, callback_assignments[i].address);
-    address += sizeof(address_t);
-  }
-  for (uint8_t i = 0; i < MAX_CALLBACK_ASSIGNMENTS; ++i)
-  {
-    EEPROM.get(address, callback_assignments[i].callback_id);
-    address += sizeof(callback_id_t);
-  }
-  EEPROM.get(address, physaddr);
-  address += sizeof(address_t); 
-
-  //EEPROM.get(address, custom_config_data);
-  //address += sizeof(custom_config_data);
-  uint32_t conf_offset = address;
-  for (uint8_t i = 0; i < registered_configs; ++i)
-  {
-    // First byte is flags.
-    config_flags_t flags = CONFIG_FLAGS_NO_FLAGS;
-    flags = (config_flags_t)EEPROM.read(address);
-    DEBUG_PRINT("Flag in EEPROM @ ");
-    DEBUG_PRINT(address - conf_offset);
-    DEBUG_PRINT(": ");
-    DEBUG_PRINTLN(flags, BIN);
-    custom_config_data[custom_configs[i].offset] = flags;
-    if (flags & CONFIG_FLAGS_VALUE_SET)
+
+  __eeprom_records_apply(EEPROM.getDataPtr() + address, EEPROM_SIZE - address, false);
+
+  // RAM and EEPROM are in sync now
+  __eeprom_mark_clean();
+  if (!found && __eeprom_slots_usable())
+    eeprom_dirty |= EEPROM_DIRTY_MAGIC;
+
+  DEBUG_PRINTLN("Restored from EEPROM");
+}
+
+/**
+ * Applies the records of an EEPROM image, data points to the first record after the magic. Records of unknown
+ * items are skipped. With dry_run, nothing is changed and false is returned if the image is truncated or a record
+ * does not fit its item, so an import can be checked completely before anything is applied.
+ */
+bool ESPKNXIP::__eeprom_records_apply(uint8_t const *data, uint16_t len, bool dry_run)
+{
+  uint16_t address = 0;
+  uint32_t assignments = 0;
+  if (!dry_run)
+  {
+    registered_callback_assignments = 0;
+    for (callback_assignment_id_t i = 0; i < callback_assignments_capacity; ++i)
+    {
+      callback_assignments[i].callback_id = -1;
+    }
+  }
+  while (address + EEPROM_RECORD_HEADER_SIZE <= len)
+  {
+    uint8_t tag = data[address];
+    if (tag == EEPROM_RECORD_END)
+      return assignments <= MAX_CALLBACK_ASSIGNMENTS;
+
+    uint8_t value_len = data[address + 1];
+    uint32_t key = 0;
+    for (uint8_t i = 0; i < sizeof(uint32_t); ++i)
     {
-      DEBUG_PRINTLN("Non-default value");
-      for (int j = 0; j < custom_configs[i].len - sizeof(uint8_t); ++j)
+      key |= (uint32_t)data[address + 2 + i] << (i * 8);
+    }
+    address += EEPROM_RECORD_HEADER_SIZE;
+    if (address + value_len > len)
+      break;
+    uint8_t const *value = data + address;
+    address += value_len;
+
+    switch (tag)
+    {
+      case EEPROM_RECORD_PHYSADDR:
+        if (value_len != sizeof(address_t))
+        {
+          if (dry_run)
+            return false;
+        }
+        else if (!dry_run)
+        {
+          memcpy(physaddr.array, value, sizeof(address_t));
+        }
+        break;
+      case EEPROM_RECORD_ASSIGNMENT:
+      {
+        callback_id_t cb = __callback_find_key(key);
+        if (cb == (callback_id_t)-1)
+        {
+          DEBUG_PRINTLN("Skipping assignment of unknown callback");
+          break;
+        }
+        if (value_len != sizeof(address_t))
+        {
+          if (dry_run)
+            return false;
+          break;
+        }
+        assignments++;
+        if (dry_run)
+          break;
+        if (!__callback_assignments_reserve(registered_callback_assignments + 1))
+        {
+          DEBUG_PRINTLN("No space for assignment");
+          break;
+        }
+        callback_assignments[registered_callback_assignments].address.bytes.high = value[0];
+        callback_assignments[registered_callback_assignments].address.bytes.low = value[1];
+        callback_assignments[registered_callback_assignments].callback_id = cb;
+        registered_callback_assignments++;
+        break;
+      }
+      case EEPROM_RECORD_CONFIG:
       {
-        custom_config_data[custom_configs[i].offset + sizeof(uint8_t) + j] = EEPROM.read(address + sizeof(uint8_t) + j);
+        config_id_t id = __config_find_key(key);
+        if (id == (config_id_t)-1)
+        {
+          DEBUG_PRINTLN("Skipping unknown config");
+          break;
+        }
+        if (!__config_restore(id, value_len, value, dry_run))
+        {
+          DEBUG_PRINTLN("Skipping invalid config");
+          if (dry_run)
+            return false;
+        }
+        break;
       }
+      default:
+        DEBUG_PRINTLN("Skipping unknown record");
+        break;
     }
+  }
+
+  // No end tag
+  return false;
+}
+
+/**
+ * String pool functions
+ * All names are interned in one append-only block. Items reference their name by offset, so the block can
+ * move when it grows. Pointers returned by __string_pool_get() are only valid until the next string is added.
+ */
+
+/**
+ * Returns the reference of an equal string in the pool or appends it. Flash strings are not copied, only a
+ * reference to them is added. str may point into the pool itself, e.g. from __string_pool_get().
+ * Returns -1 if the pool is full.
+ */
+string_ref_t ESPKNXIP::__string_pool_add(const __FlashStringHelper *str)
+{
+  PGM_P p = (PGM_P)str;
+  if (string_pool != nullptr && p >= string_pool && p < string_pool + string_pool_len)
+    return p - string_pool;
 
-    address += custom_configs[i].len;
+  for (uint16_t i = 0; i < string_pool_len; )
+  {
+    if (__string_equals((PGM_P)__string_pool_get(i), p))
+      return i;
+    i += (string_pool[i] == STRING_POOL_FLASH) ? 1 + sizeof(PGM_P) : strlen(&string_pool[i]) + 1;
+  }
+
+  bool flash = __in_flash(p);
+  uint16_t len = flash ? 1 + sizeof(PGM_P) : strlen_P(p) + 1;
+  if (!__registry_reserve((void **)&string_pool, string_pool_capacity, (uint32_t)string_pool_len + len, sizeof(char), 0xFFFF))
+    return -1;
+
+  string_ref_t ref = string_pool_len;
+  if (flash)
+  {
+    string_pool[ref] = STRING_POOL_FLASH;
+    memcpy(&string_pool[ref + 1], &p, sizeof(PGM_P));
+  }
+  else
+  {
+    memcpy_P(&string_pool[ref], p, len);
+  }
+  string_pool_len += len;
+  return ref;
+}
+
+string_ref_t ESPKNXIP::__string_pool_add(String const &str)
+{
+  return __string_pool_add((const __FlashStringHelper *)str.c_str());
+}
+
+const __FlashStringHelper *ESPKNXIP::__string_pool_get(string_ref_t ref)
+{
+  if (ref >= string_pool_len)
+    return F("");
+
+  if (string_pool[ref] == STRING_POOL_FLASH)
+  {
+    PGM_P p;
+    memcpy(&p, &string_pool[ref + 1], sizeof(PGM_P));
+    return (const __FlashStringHelper *)p;
+  }
+  return (const __FlashStringHelper *)&string_pool[ref];
+}
+
+bool ESPKNXIP::__string_equals(PGM_P a, PGM_P b)
+{
+  uint8_t c;
+  do
+  {
+    c = pgm_read_byte(a++);
+    if (c != pgm_read_byte(b++))
+      return false;
+  } while (c != 0);
+  return true;
+}
+
+/**
+ * Storage index functions
+ * Stored configs and assignments are identified by the hash of the config or callback name. The hash tables
+ * are built once in load(), so restore can find each item in O(1).
+ */
+
+uint32_t ESPKNXIP::__name_hash(const __FlashStringHelper *name)
+{
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  PGM_P p = (PGM_P)name;
+  for (uint8_t c = pgm_read_byte(p); c != 0; c = pgm_read_byte(++p))
+  {
+    h ^= c;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+void ESPKNXIP::__storage_index_build()
+{
+  // One more slot than twice the items, so there always is an empty slot that ends the search
+  free(config_index);
+  config_index_size = 2 * registered_configs + 1;
+  config_index = (config_id_t *)malloc(config_index_size * sizeof(config_id_t));
+  if (config_index == nullptr)
+    config_index_size = 0;
+  else
+    memset(config_index, 0xFF, config_index_size * sizeof(config_id_t));
+  for (config_id_t i = 0; i < registered_configs && config_index != nullptr; ++i)
+  {
+    uint32_t slot = custom_configs[i].key % config_index_size;
+    while (config_index[slot] != (config_id_t)-1)
+    {
+      if (custom_configs[config_index[slot]].key == custom_configs[i].key)
+      {
+        DEBUG_PRINT("Config name collides with another one: ");
+        DEBUG_PRINTLN(__string_pool_get(custom_configs[i].name));
+      }
+      slot = (slot + 1) % config_index_size;
+    }
+    config_index[slot] = i;
+  }
+
+  free(callback_index);
+  callback_index_size = 2 * registered_callbacks + 1;
+  callback_index = (callback_id_t *)malloc(callback_index_size * sizeof(callback_id_t));
+  if (callback_index == nullptr)
+    callback_index_size = 0;
+  else
+    memset(callback_index, 0xFF, callback_index_size * sizeof(callback_id_t));
+  for (callback_id_t i = 0; i < registered_callbacks && callback_index != nullptr; ++i)
+  {
+    uint32_t slot = callbacks[i].key % callback_index_size;
+    while (callback_index[slot] != (callback_id_t)-1)
+    {
+      if (callbacks[callback_index[slot]].key == callbacks[i].key)
+      {
+        DEBUG_PRINT("Callback name collides with another one: ");
+        DEBUG_PRINTLN(__string_pool_get(callbacks[i].name));
+      }
+      slot = (slot + 1) % callback_index_size;
+    }
+    callback_index[slot] = i;
+  }
+}
+
+config_id_t ESPKNXIP::__config_find_key(uint32_t key)
+{
+  if (config_index_size == 0)
+    return -1;
+
+  for (uint32_t slot = key % config_index_size; config_index[slot] != (config_id_t)-1; slot = (slot + 1) % config_index_size)
+  {
+    if (custom_configs[config_index[slot]].key == key)
+      return config_index[slot];
+  }
+  return -1;
+}
+
+callback_id_t ESPKNXIP::__callback_find_key(uint32_t key)
+{
+  if (callback_index_size == 0)
+    return -1;
+
+  for (uint32_t slot = key % callback_index_size; callback_index[slot] != (callback_id_t)-1; slot = (slot + 1) % callback_index_size)
+  {
+    if (callbacks[callback_index[slot]].key == key)
+      return callback_index[slot];
   }
+  return -1;
+}
 
-  DEBUG_PRINT("Restored from EEPROM: 0x");
-  DEBUG_PRINTLN(address, HEX);
+bool ESPKNXIP::__in_flash(const void *p)
+{
+  // Flash is mapped from 0x40200000
+  return (uintptr_t)p >= 0x40200000;
 }
 
 uint16_t ESPKNXIP::__ntohs(uint16_t n)
@@ -180,9 +991,25 @@ uint16_t ESPKNXIP::__ntohs(uint16_t n)
   return (uint16_t)((((uint8_t*)&n)[0] << 8) | (((uint8_t*)&n)[1]));
 }
 
+/**
+ * CRC-16/CCITT
+ */
+uint16_t ESPKNXIP::__crc16(uint8_t const *data, uint32_t len, uint16_t crc)
+{
+  for (uint32_t i = 0; i < len; ++i)
+  {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t j = 0; j < 8; ++j)
+    {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
 callback_assignment_id_t ESPKNXIP::__callback_register_assignment(address_t address, callback_id_t id)
 {
-  if (registered_callback_assignments >= MAX_CALLBACK_ASSIGNMENTS)
+  if (!__callback_assignments_reserve(registered_callback_assignments + 1))
     return -1;
 
   callback_assignment_id_t aid = registered_callback_assignments;
@@ -190,6 +1017,7 @@ callback_assignment_id_t ESPKNXIP::__callback_register_assignment(address_t addr
   callback_assignments[aid].address = address;
   callback_assignments[aid].callback_id = id;
   registered_callback_assignments++;
+  __eeprom_mark_assignments_dirty(aid);
   return aid;
 }
 
@@ -231,23 +1059,41 @@ void ESPKNXIP::__callback_delete_assignment(callback_assignment_id_t id)
   }
 
   registered_callback_assignments--;
+  callback_assignments[registered_callback_assignments].callback_id = -1;
+  __eeprom_mark_assignments_dirty(id);
 }
 
-callback_id_t ESPKNXIP::callback_register(String name, callback_fptr_t cb, void *arg, enable_condition_t cond)
+callback_id_t ESPKNXIP::callback_register(const __FlashStringHelper *name, callback_fptr_t cb, void *arg, enable_condition_t cond)
 {
-  if (registered_callbacks >= MAX_CALLBACKS)
+  if (!__registry_reserve((void **)&callbacks, callbacks_capacity, registered_callbacks + 1, sizeof(callback_t), MAX_CALLBACKS))
     return -1;
 
   callback_id_t id = registered_callbacks;
 
-  callbacks[id].name = name;
+  callbacks[id].name = __string_pool_add(name);
+  if (callbacks[id].name == (string_ref_t)-1)
+    return -1;
+  callbacks[id].key = __name_hash(name);
   callbacks[id].fkt = cb;
   callbacks[id].cond = cond;
   callbacks[id].arg = arg;
+  callbacks[id].calls = 0;
+#if !DISABLE_CALLBACK_TIMING
+  memset(&callbacks[id].timing, 0, sizeof(callback_timing_t));
+#endif
   registered_callbacks++;
+  state_version++;
   return id;
 }
 
+callback_id_t ESPKNXIP::callback_register(String name, callback_fptr_t cb, void *arg, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return callback_register(__string_pool_get(ref), cb, arg, cond);
+}
+
 void ESPKNXIP::callback_assign(callback_id_t id, address_t val)
 {
   if (id >= registered_callbacks)
@@ -256,86 +1102,309 @@ void ESPKNXIP::callback_assign(callback_id_t id, address_t val)
   __callback_register_assignment(val, id);
 }
 
+void ESPKNXIP::callback_set_sync(callback_id_t id, bool sync)
+{
+  if (id >= registered_callbacks)
+    return;
+
+  callbacks[id].sync = sync;
+}
+
 /**
  * Feedback functions start here
  */
 
-feedback_id_t ESPKNXIP::feedback_register_int(String name, int32_t *value, enable_condition_t cond)
+feedback_id_t ESPKNXIP::feedback_register_int(const __FlashStringHelper *name, int32_t *value, enable_condition_t cond)
 {
-  if (registered_feedbacks >= MAX_FEEDBACKS)
+  if (!__registry_reserve((void **)&feedbacks, feedbacks_capacity, registered_feedbacks + 1, sizeof(feedback_t), MAX_FEEDBACKS))
     return -1;
 
   feedback_id_t id = registered_feedbacks;
 
   feedbacks[id].type = FEEDBACK_TYPE_INT;
-  feedbacks[id].name = name;
+  feedbacks[id].name = __string_pool_add(name);
+  if (feedbacks[id].name == (string_ref_t)-1)
+    return -1;
   feedbacks[id].cond = cond;
   feedbacks[id].data = (void *)value;
 
   registered_feedbacks++;
+  state_version++;
 
   return id;
 }
 
-feedback_id_t ESPKNXIP::feedback_register_float(String name, float *value, uint8_t precision, enable_condition_t cond)
+feedback_id_t ESPKNXIP::feedback_register_float(const __FlashStringHelper *name, float *value, uint8_t precision, enable_condition_t cond)
 {
-  if (registered_feedbacks >= MAX_FEEDBACKS)
+  if (!__registry_reserve((void **)&feedbacks, feedbacks_capacity, registered_feedbacks + 1, sizeof(feedback_t), MAX_FEEDBACKS))
     return -1;
 
   feedback_id_t id = registered_feedbacks;
 
   feedbacks[id].type = FEEDBACK_TYPE_FLOAT;
-  feedbacks[id].name = name;
+  feedbacks[id].name = __string_pool_add(name);
+  if (feedbacks[id].name == (string_ref_t)-1)
+    return -1;
   feedbacks[id].cond = cond;
   feedbacks[id].data = (void *)value;
   feedbacks[id].options.float_options.precision = precision;
 
   registered_feedbacks++;
+  state_version++;
 
   return id;
 }
 
-feedback_id_t ESPKNXIP::feedback_register_bool(String name, bool *value, enable_condition_t cond)
+feedback_id_t ESPKNXIP::feedback_register_bool(const __FlashStringHelper *name, bool *value, enable_condition_t cond)
 {
-  if (registered_feedbacks >= MAX_FEEDBACKS)
+  if (!__registry_reserve((void **)&feedbacks, feedbacks_capacity, registered_feedbacks + 1, sizeof(feedback_t), MAX_FEEDBACKS))
     return -1;
 
   feedback_id_t id = registered_feedbacks;
 
   feedbacks[id].type = FEEDBACK_TYPE_BOOL;
-  feedbacks[id].name = name;
+  feedbacks[id].name = __string_pool_add(name);
+  if (feedbacks[id].name == (string_ref_t)-1)
+    return -1;
   feedbacks[id].cond = cond;
   feedbacks[id].data = (void *)value;
 
   registered_feedbacks++;
+  state_version++;
 
   return id;
 }
 
-feedback_id_t ESPKNXIP::feedback_register_action(String name, feedback_action_fptr_t value, void *arg, enable_condition_t cond)
+feedback_id_t ESPKNXIP::feedback_register_action(const __FlashStringHelper *name, feedback_action_fptr_t value, void *arg, enable_condition_t cond)
 {
-  if (registered_feedbacks >= MAX_FEEDBACKS)
+  if (!__registry_reserve((void **)&feedbacks, feedbacks_capacity, registered_feedbacks + 1, sizeof(feedback_t), MAX_FEEDBACKS))
     return -1;
 
   feedback_id_t id = registered_feedbacks;
 
   feedbacks[id].type = FEEDBACK_TYPE_ACTION;
-  feedbacks[id].name = name;
+  feedbacks[id].name = __string_pool_add(name);
+  if (feedbacks[id].name == (string_ref_t)-1)
+    return -1;
   feedbacks[id].cond = cond;
   feedbacks[id].data = (void *)value;
   feedbacks[id].options.action_options.arg = arg;
 
   registered_feedbacks++;
+  state_version++;
 
   return id;
 }
 
+feedback_id_t ESPKNXIP::feedback_register_int(String name, int32_t *value, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return feedback_register_int(__string_pool_get(ref), value, cond);
+}
+
+feedback_id_t ESPKNXIP::feedback_register_float(String name, float *value, uint8_t precision, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return feedback_register_float(__string_pool_get(ref), value, precision, cond);
+}
+
+feedback_id_t ESPKNXIP::feedback_register_bool(String name, bool *value, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return feedback_register_bool(__string_pool_get(ref), value, cond);
+}
+
+feedback_id_t ESPKNXIP::feedback_register_action(String name, feedback_action_fptr_t value, void *arg, enable_condition_t cond)
+{
+  string_ref_t ref = __string_pool_add(name);
+  if (ref == (string_ref_t)-1)
+    return -1;
+  return feedback_register_action(__string_pool_get(ref), value, arg, cond);
+}
+
 void ESPKNXIP::loop()
 {
+  uint32_t start = micros();
+  loop_dispatch_time = 0;
+#if !DISABLE_MEMORY_STATS
+  uint8_t stack_marker;
+  stack_base = (uintptr_t)&stack_marker;
+#endif
   __loop_knx();
+  uint32_t now = micros();
+  __loop_phase_record(LOOP_PHASE_DISPATCH, loop_dispatch_time);
+  __loop_phase_record(LOOP_PHASE_RECEIVE, now - start - loop_dispatch_time);
+  uint32_t last = now;
+
+  __loop_read_requests();
+  __loop_sync();
+  __loop_cyclic();
+  now = micros();
+  __loop_phase_record(LOOP_PHASE_TIMERS, now - last);
+  last = now;
+
+  __loop_transport();
+  now = micros();
+  __loop_phase_record(LOOP_PHASE_TRANSPORT, now - last);
+  last = now;
+
   if (server != nullptr)
   {
-    __loop_webserver();
+    // Telegrams come first. Web handling waits one call at most, so the web ui stays usable under load.
+    if (loop_budget > 0 && now - start > loop_budget && !loop_deferred)
+    {
+      loop_deferred = true;
+      loop_phases[LOOP_PHASE_WEB].deferred++;
+#if !DISABLE_EVENTS
+      loop_phases[LOOP_PHASE_EVENTS].deferred++;
+#endif
+    }
+    else
+    {
+      loop_deferred = false;
+      __loop_webserver();
+      now = micros();
+      __loop_phase_record(LOOP_PHASE_WEB, now - last);
+      last = now;
+#if !DISABLE_EVENTS
+      __loop_events();
+      now = micros();
+      __loop_phase_record(LOOP_PHASE_EVENTS, now - last);
+#endif
+    }
+  }
+
+#if !DISABLE_MEMORY_STATS
+  stack_base = 0;
+#endif
+
+  uint32_t duration = micros() - start;
+  metrics.loops++;
+  metrics.loop_time += duration;
+  if (duration > metrics.loop_time_max)
+    metrics.loop_time_max = duration;
+
+  // The maxima of the last window are kept, so a report right after the switch still covers a full window
+  if ((long)(millis() - loop_window_end) >= 0)
+  {
+    for (uint8_t i = 0; i < LOOP_PHASE_COUNT; ++i)
+    {
+      loop_phases[i].last_max = loop_phases[i].max;
+      loop_phases[i].max = 0;
+    }
+    loop_window_end = millis() + LOOP_PROFILE_WINDOW;
+  }
+}
+
+void ESPKNXIP::__loop_phase_record(loop_phase_t phase, uint32_t duration)
+{
+  loop_phase_stats_t &p = loop_phases[phase];
+  p.mean = p.mean - p.mean / 16 + duration;
+  if (duration > p.max)
+    p.max = duration;
+}
+
+PGM_P ESPKNXIP::__loop_phase_name(loop_phase_t phase)
+{
+  switch (phase)
+  {
+    case LOOP_PHASE_RECEIVE: return PSTR("receive");
+    case LOOP_PHASE_DISPATCH: return PSTR("dispatch");
+    case LOOP_PHASE_TIMERS: return PSTR("timers");
+    case LOOP_PHASE_TRANSPORT: return PSTR("transport");
+    case LOOP_PHASE_WEB: return PSTR("web");
+    case LOOP_PHASE_EVENTS: return PSTR("events");
+    default: return PSTR("");
+  }
+}
+
+void ESPKNXIP::loop_budget_set(uint32_t us)
+{
+  loop_budget = us;
+}
+
+void ESPKNXIP::loop_report(Print &out)
+{
+  out.println(F("Loop report"));
+  out.printf_P(PSTR("Loops:     %u, mean %u us, max %u us, budget %u us\n"), metrics.loops,
+    metrics.loops > 0 ? (uint32_t)(metrics.loop_time / metrics.loops) : 0, metrics.loop_time_max, loop_budget);
+  for (uint8_t i = 0; i < LOOP_PHASE_COUNT; ++i)
+  {
+    loop_phase_t phase = (loop_phase_t)i;
+    out.printf_P(PSTR("%-10s mean %u us, max %u us, deferred %u\n"), __loop_phase_name(phase),
+      loop_phases[i].mean / 16, __loop_phase_max(phase), loop_phases[i].deferred);
+  }
+}
+
+/**
+ * Cyclic functions
+ * Each function is run every period ms. The first run is delayed by a phase offset derived from the chip id
+ * and the function id, so functions with equal periods and devices started together do not run in lockstep.
+ */
+
+cyclic_id_t ESPKNXIP::cyclic_register(uint32_t period, cyclic_fptr_t fkt, void *arg, enable_condition_t cond)
+{
+  if (registered_cyclics >= MAX_CYCLICS)
+    return -1;
+
+  cyclic_id_t id = registered_cyclics;
+
+  cyclics[id].fkt = fkt;
+  cyclics[id].arg = arg;
+  cyclics[id].cond = cond;
+  cyclics[id].period = period;
+  __cyclic_schedule(id);
+
+  registered_cyclics++;
+
+  return id;
+}
+
+void ESPKNXIP::cyclic_set_period(cyclic_id_t id, uint32_t period)
+{
+  if (id >= registered_cyclics || cyclics[id].period == period)
+    return;
+
+  cyclics[id].period = period;
+  __cyclic_schedule(id);
+}
+
+void ESPKNXIP::__cyclic_schedule(cyclic_id_t id)
+{
+  if (cyclics[id].period == 0)
+    return;
+
+  cyclics[id].next_run = millis() + __device_hash(id) % cyclics[id].period;
+}
+
+void ESPKNXIP::__loop_cyclic()
+{
+  unsigned long now = millis();
+  uint8_t run = 0;
+
+  // Start where the last call stopped, so every function gets its turn even if the cap is hit
+  for (cyclic_id_t n = 0; n < registered_cyclics && run < CYCLIC_MAX_PER_LOOP; ++n)
+  {
+    cyclic_id_t id = (next_cyclic + n) % registered_cyclics;
+    cyclic_t &c = cyclics[id];
+    if (c.period == 0 || (long)(now - c.next_run) < 0)
+      continue;
+
+    // Keep the phase, even if we fell behind by more than one period
+    c.next_run += ((now - c.next_run) / c.period + 1) * c.period;
+    next_cyclic = (id + 1) % registered_cyclics;
+
+    if (c.cond && !c.cond())
+      continue;
+
+    c.fkt(c.arg);
+    run++;
   }
 }
 
@@ -351,11 +1420,15 @@ void ESPKNXIP::__loop_knx()
   {
     return;
   }
+  metrics.rx_packets++;
   DEBUG_PRINTLN(F(""));
   DEBUG_PRINT(F("LEN: "));
   DEBUG_PRINTLN(read);
 
   uint8_t buf[read];
+#if !DISABLE_MEMORY_STATS
+  __stack_sample(buf);
+#endif
 
   udp.read(buf, read);
   udp.flush();
@@ -374,7 +1447,10 @@ void ESPKNXIP::__loop_knx()
   DEBUG_PRINTLN(__ntohs(knx_pkt->service_type), 16);
 
   if (knx_pkt->header_len != 0x06 && knx_pkt->protocol_version != 0x10 && knx_pkt->service_type != KNX_ST_ROUTING_INDICATION)
+  {
+    metrics.rx_dropped++;
     return;
+  }
 
   cemi_msg_t *cemi_msg = (cemi_msg_t *)knx_pkt->pkt_data;
 
@@ -382,7 +1458,10 @@ void ESPKNXIP::__loop_knx()
   DEBUG_PRINTLN(cemi_msg->message_code, 16);
 
   if (cemi_msg->message_code != KNX_MT_L_DATA_IND)
+  {
+    metrics.rx_dropped++;
     return;
+  }
 
   DEBUG_PRINT(F("ADDI: 0x"));
   DEBUG_PRINTLN(cemi_msg->additional_info_len, 16);
@@ -402,6 +1481,19 @@ void ESPKNXIP::__loop_knx()
   DEBUG_PRINTLN(cemi_data->control_2.bits.dest_addr_type, 16);
 
   if (cemi_data->control_2.bits.dest_addr_type != 0x01)
+  {
+    // Individual addressed telegrams are handled by the transport layer if they are meant for us
+    if (cemi_data->destination.value == physaddr.value)
+      __transport_receive(cemi_data);
+    return;
+  }
+
+#if !DISABLE_BUS_MONITOR
+  __monitor_capture(cemi_data);
+#endif
+
+  // With loopback our own telegrams were already dispatched when they were sent
+  if (loopback_mode != LOOPBACK_OFF && cemi_data->source.value == physaddr.value)
     return;
 
   DEBUG_PRINT(F("HC: 0x"));
@@ -433,6 +1525,81 @@ void ESPKNXIP::__loop_knx()
 
   DEBUG_PRINTLN(F("=="));
 
+  if (cemi_data->data_len == 0)
+  {
+    metrics.rx_dropped++;
+    return;
+  }
+
+  // Callbacks get the data without the command type bits
+  uint8_t data[cemi_data->data_len];
+#if !DISABLE_MEMORY_STATS
+  __stack_sample(data);
+#endif
+  memcpy(data, cemi_data->data, cemi_data->data_len);
+  data[0] = data[0] & 0x3F;
+
+#if !DISABLE_EVENTS
+  __event_telegram(cemi_data, ct, cemi_data->data_len, data);
+#endif
+  uint32_t dispatch_start = micros();
+  __dispatch(cemi_data->destination, ct, cemi_data->data_len, data);
+  loop_dispatch_time += micros() - dispatch_start;
+}
+
+/**
+ * Parses "area[/line[/member]]" (group) or "area[.line[.member]]" (physical), an empty string matches all
+ */
+bool ESPKNXIP::__address_filter_parse(String const &str, address_filter_t &filter, bool group)
+{
+  memset(&filter, 0, sizeof(address_filter_t));
+  if (str.length() == 0)
+    return true;
+
+  int area = 0, line = 0, member = 0;
+  int parts = sscanf(str.c_str(), group ? "%d/%d/%d" : "%d.%d.%d", &area, &line, &member);
+  if (parts < 1 || area < 0 || line < 0 || member < 0 || area > (group ? 31 : 15) || line > (group ? 7 : 15) || member > 255)
+    return false;
+
+  filter.address = group ? GA_to_address(area, line, member) : PA_to_address(area, line, member);
+  if (parts >= 1)
+    filter.mask_high = group ? 0xF8 : 0xF0;
+  if (parts >= 2)
+    filter.mask_high = 0xFF;
+  if (parts >= 3)
+    filter.mask_low = 0xFF;
+  return true;
+}
+
+size_t ESPKNXIP::__address_filter_print(Print &out, address_filter_t const &filter, bool group)
+{
+  if (filter.mask_high == 0)
+    return 0;
+  char sep = group ? '/' : '.';
+  size_t n = out.print(group ? filter.address.ga.area : filter.address.pa.area);
+  if (filter.mask_high == 0xFF)
+  {
+    n += out.print(sep);
+    n += out.print(group ? filter.address.ga.line : filter.address.pa.line);
+  }
+  if (filter.mask_low == 0xFF)
+  {
+    n += out.print(sep);
+    n += out.print(filter.address.ga.member);
+  }
+  return n;
+}
+
+/**
+ * Passes a group telegram to pending read requests and assigned callbacks.
+ * data must already have the command type bits removed.
+ */
+void ESPKNXIP::__dispatch(address_t const &destination, knx_command_type_t ct, uint8_t data_len, uint8_t *data)
+{
+  metrics.rx_telegrams++;
+  if (ct == KNX_CT_ANSWER)
+    __read_request_resolve(destination, data_len, data);
+
   // Call callbacks
   for (int i = 0; i < registered_callback_assignments; ++i)
   {
@@ -440,27 +1607,15 @@ void ESPKNXIP::__loop_knx()
     DEBUG_PRINT(callback_assignments[i].address.bytes.high, 16);
     DEBUG_PRINT(F(" 0x"));
     DEBUG_PRINTLN(callback_assignments[i].address.bytes.low, 16);
-    if (cemi_data->destination.value == callback_assignments[i].address.value)
+    if (destination.value == callback_assignments[i].address.value)
     {
       DEBUG_PRINTLN(F("Found match"));
-      if (callbacks[callback_assignments[i].callback_id].cond && !callbacks[callback_assignments[i].callback_id].cond())
-      {
-        DEBUG_PRINTLN(F("But it's disabled"));
-#if ALLOW_MULTIPLE_CALLBACKS_PER_ADDRESS
-        continue;
-#else
-        return;
-#endif
-      }
-      uint8_t data[cemi_data->data_len];
-      memcpy(data, cemi_data->data, cemi_data->data_len);
-      data[0] = data[0] & 0x3F;
       message_t msg = {};
       msg.ct = ct;
-      msg.received_on = cemi_data->destination;
-      msg.data_len = cemi_data->data_len;
+      msg.received_on = destination;
+      msg.data_len = data_len;
       msg.data = data;
-      callbacks[callback_assignments[i].callback_id].fkt(msg, callbacks[callback_assignments[i].callback_id].arg);
+      __callback_call(callback_assignments[i].callback_id, msg);
 #if ALLOW_MULTIPLE_CALLBACKS_PER_ADDRESS
       continue;
 #else
@@ -472,5 +1627,65 @@ void ESPKNXIP::__loop_knx()
   return;
 }
 
+/**
+ * Calls a callback unless its enable condition is false, counting and timing the call. Every callback call goes
+ * through here. Returns false if the callback is disabled.
+ */
+bool ESPKNXIP::__callback_call(callback_id_t id, message_t const &msg)
+{
+  callback_t &cb = callbacks[id];
+  if (cb.cond && !cb.cond())
+  {
+    DEBUG_PRINTLN(F("But it's disabled"));
+    return false;
+  }
+#if !DISABLE_MEMORY_STATS
+  __stack_sample(&id);
+#endif
+  cb.calls++;
+#if !DISABLE_CALLBACK_TIMING
+  uint32_t start = micros();
+#endif
+  cb.fkt(msg, cb.arg);
+#if !DISABLE_CALLBACK_TIMING
+  __callback_timing_record(id, micros() - start, msg.received_on);
+#endif
+  return true;
+}
+
+#if !DISABLE_CALLBACK_TIMING
+/**
+ * Counts a call of a callback in the bucket of its duration and reports it if it was slow
+ */
+void ESPKNXIP::__callback_timing_record(callback_id_t id, uint32_t duration, address_t const &destination)
+{
+  callback_timing_t &t = callbacks[id].timing;
+  uint8_t bucket = 0;
+  while (bucket < __CALLBACK_TIMING_BUCKETS - 1 && duration > __callback_timing_limit(bucket))
+    bucket++;
+  t.buckets[bucket]++;
+  t.total += duration;
+  if (duration > t.max)
+    t.max = duration;
+
+  if (duration <= SLOW_CALLBACK_THRESHOLD)
+    return;
+
+  t.slow++;
+  slow_callback.id = id;
+  slow_callback.address = destination;
+  slow_callback.duration = duration;
+  slow_callback.time = millis();
+  DEBUG_PRINT(F("Slow callback "));
+  DEBUG_PRINT(id);
+  DEBUG_PRINT(F(": "));
+  DEBUG_PRINT(duration);
+  DEBUG_PRINTLN(F(" us"));
+#if !DISABLE_EVENTS
+  __event_slow_callback(slow_callback);
+#endif
+}
+#endif
+
 // Global "singleton" object
 ESPKNXIP knx;
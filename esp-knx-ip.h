@@ -9,27 +9,67 @@
 
 /**
  * CONFIG
- * All MAX_ values must not exceed 255 (1 byte, except MAC_CONFIG_SPACE which can go up to 2 bytes, so 0xffff in theory) and must not be negative!
+ * All MAX_ values must not exceed 65535 (2 bytes) and must not be negative!
+ * MAX_CALLBACK_ASSIGNMENTS, MAX_CALLBACKS, MAX_CONFIGS, MAX_CONFIG_SPACE and MAX_FEEDBACKS are only upper limits,
+ * RAM is allocated for the registered items only (see REGISTRY_INITIAL_CAPACITY).
  * Config space is restriced by EEPROM_SIZE (default 1024).
- * Required EEPROM size is 8 + MAX_GA_CALLBACKS * 3 + 2 + MAX_CONFIG_SPACE which is 552 by default
+ * Required EEPROM size is 8 + 8 + MAX_CALLBACK_ASSIGNMENTS * 8 + (6 + length of each config) + 1, see EEPROM format below
  */
-#define EEPROM_SIZE               1024 // [Default 1024]
+#define EEPROM_SIZE               1024 // [Default 1024] Must be a multiple of 4
 #define MAX_CALLBACK_ASSIGNMENTS  10 // [Default 10] Maximum number of group address callbacks that can be stored
 #define MAX_CALLBACKS             10 // [Default 10] Maximum number of callbacks that can be stored
 #define MAX_CONFIGS               20 // [Default 20] Maximum number of config items that can be stored
 #define MAX_CONFIG_SPACE          0x0200 // [Default 0x0200] Maximum number of bytes that can be stored for custom config
 
 #define MAX_FEEDBACKS             20 // [Default 20] Maximum number of feedbacks that can be shown
+#define REGISTRY_INITIAL_CAPACITY 4 // [Default 4] Number of items allocated on the first registration. Registries double their size when full and are shrunk to their exact size in load()
+
+#define MAX_READ_REQUESTS         8 // [Default 8] Maximum number of group value reads that can be outstanding at the same time
+#define READ_REQUEST_TIMEOUT      2000 // [Default 2000] Default time in ms to wait for the answer to a group value read
+#define READ_REQUEST_RESULT_LIFETIME  60000 // [Default 60000] Time in ms the result of a read request without callback is kept for polling. After that, the slot is freed even if read_request_release() was not called. Set to 0 to keep results until they are released
+
+// Cyclic functions
+#define MAX_CYCLICS               10 // [Default 10] Maximum number of cyclic functions that can be registered
+#define CYCLIC_MAX_PER_LOOP       2 // [Default 2] Maximum number of cyclic functions that are run in one loop() call, the rest is run in the next call
+
+// Startup sync
+#define SYNC_INTERVAL             100 // [Default 100] Time in ms between two reads during the startup sync
+#define SYNC_JITTER               2000 // [Default 2000] Maximum delay in ms before the startup sync begins. The actual delay is derived from the chip id, so devices powered up together do not read at the same time
+#define SYNC_RETRIES              2 // [Default 2] Number of additional rounds in which missing answers are read again
 
 // Callbacks
 #define ALLOW_MULTIPLE_CALLBACKS_PER_ADDRESS  0 // [Default 0] Set to 1 to always test all assigned callbacks. This allows for multiple callbacks being assigned to the same address. If disabled, only the first assigned will be called.
+#define LOOP_BUDGET               0 // [Default 0] Time in us a call of loop() should take at most. If receiving and processing telegrams used it up, web handling waits for the next call (but never twice in a row). Can be changed at runtime with loop_budget_set(). 0 disables
+#define LOOP_PROFILE_WINDOW       10000 // [Default 10000] Phase maxima in loop_report() and the metrics cover the last one to two windows of this many ms
+#define LOOPBACK_DEFAULT          LOOPBACK_OFF // [Default LOOPBACK_OFF] Set to LOOPBACK_BEFORE_SEND or LOOPBACK_AFTER_SEND to pass telegrams sent by this device to its own callbacks. Can be changed at runtime with loopback_set(). Requires a unique physical address.
+#define LOOPBACK_QUEUE_SIZE       8 // [Default 8] Telegrams sent by callbacks while a looped back telegram is dispatched are queued and looped back after it, at most this many per telegram sent from outside a callback. Further ones, e.g. from a callback sending to its own group address, only go to the bus
+#define LOOPBACK_DATA_LEN         15 // [Default 15] Longest payload a queued telegram can have, longer ones only go to the bus
 
 // Webserver related
-#define USE_BOOTSTRAP             1 // [Default 1] Set to 1 to enable use of bootstrap CSS for nicer webconfig. CSS is loaded from bootstrapcdn.com. Set to 0 to disable
+#define USE_BOOTSTRAP             1 // [Default 1] Set to 1 to enable the bootstrap style stylesheet for nicer webconfig. It is stored gzipped in flash (about 1 kB) and cached by the browser, no external server is needed. Set to 0 to disable
 #define ROOT_PREFIX               ""  // [Default ""] This gets prepended to all webserver paths, default is empty string "". Set this to "/knx" if you want the config to be available on http://<ip>/knx
 #define DISABLE_EEPROM_BUTTONS    0 // [Default 0] Set to 1 to disable the EEPROM buttons in the web ui.
 #define DISABLE_REBOOT_BUTTON     0 // [Default 0] Set to 1 to disable the reboot button in the web ui.
 #define DISABLE_RESTORE_BUTTON    0 // [Default 0] Set to 1 to disable the "restore defaults" button in the web ui.
+#define WEB_CHUNK_SIZE            256 // [Default 256] Pages are sent in chunks of this size using chunked transfer encoding. The buffer is allocated on the stack during a request
+#define PAGE_CACHE_SIZE           4096 // [Default 4096] The rendered config page, without the feedback values, is kept in a buffer of this size until a config, assignment or registration changes. The buffer is allocated on the first request, pages that do not fit are rendered on every request. Set to 0 to disable
+#define DISABLE_EXPORT_IMPORT     0 // [Default 0] Set to 1 to disable the export and import of the whole configuration in the web ui.
+#define DISABLE_EVENTS            0 // [Default 0] Set to 1 to disable the Server-Sent Events stream of feedback values and telegrams at ROOT_PREFIX"/events"
+#define MAX_EVENT_CLIENTS         2 // [Default 2] Maximum number of clients connected to the event stream at the same time, the web ui uses one per open page
+#define EVENT_INTERVAL            250 // [Default 250] Time in ms between two checks for changed feedback values. All changes within this time are sent as one update
+#define DISABLE_BUS_MONITOR       0 // [Default 0] Set to 1 to disable the bus monitor at ROOT_PREFIX"/monitor", which keeps the last received group telegrams in RAM
+#define BUS_MONITOR_SIZE          32 // [Default 32] Number of telegrams kept by the bus monitor. Each takes 10 bytes plus BUS_MONITOR_DATA_LEN, rounded up to a multiple of 4
+#define BUS_MONITOR_DATA_LEN      6 // [Default 6] Payload bytes kept per telegram, the rest of longer payloads is cut off
+#define DISABLE_CALLBACK_TIMING   0 // [Default 0] Set to 1 to disable measuring how long each callback takes. Shown at ROOT_PREFIX"/timing", in the metrics and the JSON API
+#define SLOW_CALLBACK_THRESHOLD   20000 // [Default 20000] Callbacks running longer than this many us are reported as slow: in the debug output, as an event and on the timing page
+#define DISABLE_METRICS           0 // [Default 0] Set to 1 to disable the metrics in Prometheus text format at ROOT_PREFIX"/metrics"
+#define DISABLE_MEMORY_STATS      0 // [Default 0] Set to 1 to disable recording the heap around each web handler and save and the stack depth of loop(). Shown by memory_report(), in the metrics and the JSON API
+#define DISABLE_JSON_API          0 // [Default 0] Set to 1 to disable the JSON endpoints below ROOT_PREFIX"/api". With your own webserver passed to start(), add "If-None-Match" to your collectHeaders() call, or the endpoints never answer 304 Not Modified.
+
+// Config storage
+#define USE_CONFIG_SLOTS          0 // [Default 0] Set to 1 to save the config alternately to two flash sectors, so a power cut during a save keeps the previous config. The second sector is the one below the EEPROM sector, which is the last sector of the SPIFFS area: with 1 it is only used if the flash layout has no SPIFFS, otherwise saves go to the EEPROM sector as without slots. Set to 2 to use it anyway, only if the sketch uses no SPIFFS or LittleFS and nothing else is stored there. Slots always write the whole config
+#define USE_CONFIG_JOURNAL        0 // [Default 0] Set to 1 to store the config as an append-only journal in flash instead of the EEPROM. Saves become small appends and the wear is spread over JOURNAL_SECTORS sectors. The journal sectors are the last sectors of the SPIFFS area: with 1 the journal is only used if the flash layout has no SPIFFS, otherwise the config is saved to the EEPROM as with 0. Set to 2 to use them anyway, only if the sketch uses no SPIFFS or LittleFS and nothing else is stored there
+#define JOURNAL_SECTORS           4 // [Default 4] Number of flash sectors used by the journal. They are located right below the EEPROM sector at the end of the SPIFFS area, see USE_CONFIG_JOURNAL.
 
 // These values normally don't need adjustment
 #ifndef MULTICAST_PORT
@@ -39,6 +79,11 @@
 #define MULTICAST_IP              IPAddress(224, 0, 23, 12) // [Default IPAddress(224, 0, 23, 12)]
 #endif
 #define SEND_CHECKSUM             0
+#define READ_REQUEST_MAX_DATA     15 // [Default 15] Number of answer bytes stored per read request, 15 fits all DPTs up to DPT16
+#define TRANSPORT_CONNECTION_TIMEOUT  6000 // [Default 6000] Idle time in ms after which a point-to-point connection is closed
+#define TRANSPORT_ACK_TIMEOUT         3000 // [Default 3000] Time in ms to wait for an ACK before repeating a numbered data packet
+#define TRANSPORT_MAX_REPETITIONS     3 // [Default 3] Number of repetitions of a numbered data packet before the connection is closed
+#define TRANSPORT_MAX_APDU_LEN        66 // [Default 66] Maximum APDU length sent over a point-to-point connection. A memory answer with n bytes needs 3 + n, n can be at most 63
 
 // Uncomment to enable printing out debug messages.
 #define ESP_KNX_DEBUG
@@ -54,13 +99,25 @@
 
 #include "DPT.h"
 
-#define EEPROM_MAGIC (0xDEADBEEF00000000 + (MAX_CONFIG_SPACE) + (MAX_CALLBACK_ASSIGNMENTS << 16) + (MAX_CALLBACKS << 8))
+// ESP.getHeapFragmentation(), ESP.getMaxFreeBlockSize() and ESP.getFreeContStack() were added in core 2.5.0
+#if defined(ARDUINO_ESP8266_RELEASE_2_3_0) || defined(ARDUINO_ESP8266_RELEASE_2_4_0) || defined(ARDUINO_ESP8266_RELEASE_2_4_1) || defined(ARDUINO_ESP8266_RELEASE_2_4_2)
+#define __CORE_HAS_HEAP_STATS 0
+#else
+#define __CORE_HAS_HEAP_STATS 1
+#endif
+
+// Identifies the storage format. It does not depend on the limits or the registered items, so they can change between firmware versions
+#define EEPROM_MAGIC 0xDEADBEEF4B4E5802
+#define JOURNAL_MAGIC ((uint32_t)EEPROM_MAGIC ^ 0x4B4E584A)
+#define EEPROM_SLOT_MAGIC ((uint32_t)EEPROM_MAGIC ^ 0x4B4E5841)
 
 // Define where debug output will be printed.
 #ifndef DEBUG_PRINTER
 #define DEBUG_PRINTER Serial
 #endif
 
+#define STRING_POOL_FLASH 0x01 // Marks a string pool entry that references a flash string
+
 // Setup debug printing macros.
 #ifdef ESP_KNX_DEBUG
   #define DEBUG_PRINT(...) { DEBUG_PRINTER.print(__VA_ARGS__); }
@@ -79,6 +136,34 @@
 #define __FEEDBACK_PATH   ROOT_PREFIX"/feedback"
 #define __RESTORE_PATH    ROOT_PREFIX"/restore"
 #define __REBOOT_PATH     ROOT_PREFIX"/reboot"
+#define __EXPORT_PATH     ROOT_PREFIX"/export"
+#define __IMPORT_PATH     ROOT_PREFIX"/import"
+#define __EVENTS_PATH     ROOT_PREFIX"/events"
+#define __STYLE_PATH      ROOT_PREFIX"/static/style.css"
+#define __SCRIPT_PATH     ROOT_PREFIX"/static/app.js"
+#define __MONITOR_SCRIPT_PATH   ROOT_PREFIX"/static/monitor.js"
+#define __MONITOR_PATH    ROOT_PREFIX"/monitor"
+#define __METRICS_PATH    ROOT_PREFIX"/metrics"
+#define __TIMING_PATH     ROOT_PREFIX"/timing"
+#define __API_MONITOR_PATH      ROOT_PREFIX"/api/monitor"
+#define __API_FEEDBACK_PATH     ROOT_PREFIX"/api/feedback"
+#define __API_CONFIG_PATH       ROOT_PREFIX"/api/config"
+#define __API_ASSIGNMENTS_PATH  ROOT_PREFIX"/api/assignments"
+#define __API_PHYSADDR_PATH     ROOT_PREFIX"/api/physical_address"
+#define __API_CALLBACKS_PATH    ROOT_PREFIX"/api/callbacks"
+#define __API_MEMORY_PATH       ROOT_PREFIX"/api/memory"
+
+/**
+ * Memory map exposed via A_Memory_Read and A_Memory_Write over a point-to-point connection
+ * Physical address: 2 bytes (high, low), read only
+ * Assignments: 1 byte count, followed by MEMORY_MAX_ASSIGNMENTS entries of 3 bytes (GA high, GA low, callback id)
+ * Config: custom_config_data as it is kept in RAM, the configs in registration order, each a flags byte followed by its
+ * value. The EEPROM stores the configs as records keyed by name hash instead, see eeprom_record_tag_t
+ */
+#define MEMORY_PHYSADDR_START     0x0100
+#define MEMORY_ASSIGNMENTS_START  0x0200
+#define MEMORY_CONFIG_START       0x1000
+#define MEMORY_MAX_ASSIGNMENTS    (MAX_CALLBACK_ASSIGNMENTS < 0xFF ? MAX_CALLBACK_ASSIGNMENTS : 0xFF) // The count and callback ids are single bytes
 
 /**
  * Different service types, we are mainly interested in KNX_ST_ROUTING_INDICATION
@@ -161,6 +246,27 @@ typedef enum __knx_communication_type {
   KNX_COT_NCD = 0x03, // Numbered Control Data
 } knx_communication_type_t;
 
+/**
+ * TPCI control codes for KNX_COT_UCD (connect, disconnect) and KNX_COT_NCD (ack, nak)
+ */
+typedef enum __knx_transport_control
+{
+  KNX_TC_CONNECT    = 0x00,
+  KNX_TC_DISCONNECT = 0x01,
+  KNX_TC_ACK        = 0x02,
+  KNX_TC_NAK        = 0x03,
+} knx_transport_control_t;
+
+/**
+ * Local loopback of sent group telegrams
+ */
+typedef enum __loopback_mode
+{
+  LOOPBACK_OFF,
+  LOOPBACK_BEFORE_SEND, // Dispatch to local callbacks, then send
+  LOOPBACK_AFTER_SEND, // Send, then dispatch to local callbacks
+} loopback_mode_t;
+
 /**
  * KNX/IP header
  */
@@ -294,14 +400,29 @@ typedef struct __message
   uint8_t *data;
 } message_t;
 
+typedef enum __read_state
+{
+  READ_STATE_FREE,
+  READ_STATE_PENDING,
+  READ_STATE_ANSWERED,
+  READ_STATE_TIMEOUT,
+} read_state_t;
+
 typedef bool (*enable_condition_t)(void);
 typedef void (*callback_fptr_t)(message_t const &msg, void *arg);
 typedef void (*feedback_action_fptr_t)(void *arg);
-
-typedef uint8_t callback_id_t;
-typedef uint8_t callback_assignment_id_t;
-typedef uint8_t config_id_t;
-typedef uint8_t feedback_id_t;
+typedef void (*read_result_fptr_t)(read_state_t state, message_t const &msg, void *arg);
+typedef void (*sync_done_fptr_t)(uint16_t missing, void *arg);
+typedef void (*cyclic_fptr_t)(void *arg);
+
+typedef uint16_t callback_id_t;
+typedef uint16_t callback_assignment_id_t;
+typedef uint16_t config_id_t;
+typedef uint16_t feedback_id_t;
+typedef uint16_t string_ref_t; // Offset into the string pool
+typedef uint8_t read_request_id_t;
+#define READ_REQUEST_INVALID ((read_request_id_t)-1) // Returned by read_request() if the address is 0 or all MAX_READ_REQUESTS slots are in use
+typedef uint8_t cyclic_id_t;
 
 typedef struct __option_entry
 {
@@ -309,16 +430,45 @@ typedef struct __option_entry
   uint8_t value;
 } option_entry_t;
 
+typedef union __config_value
+{
+  int32_t i;
+  bool b;
+  uint8_t option;
+  address_t ga;
+  const char *str; // Only set for change notifications, valid during the call
+} config_value_t;
+
+typedef void (*config_changed_fptr_t)(config_id_t id, config_value_t const &old_value, config_value_t const &new_value, void *arg);
+
+/**
+ * Names and string defaults are interned in the string pool. Registered with F(), only a reference to the flash
+ * string is stored. Registered as String, the characters are copied once and shared by all items with that name.
+ */
 typedef struct __config
 {
   config_type_t type;
-  String name;
-  uint8_t offset;
+  string_ref_t name;
+  uint16_t offset;
   uint8_t len;
   enable_condition_t cond;
   union {
     option_entry_t *options;
   } data;
+  union {
+    string_ref_t str;
+    int32_t i;
+    bool b;
+    uint8_t option;
+    address_t ga;
+  } default_value; // Applied on registration and by the restore defaults button
+  config_value_t value; // Decoded copy of the value in custom_config_data, so reads are a plain load
+  config_changed_fptr_t on_change; // Called after the value changed, see config_subscribe()
+  void *on_change_arg;
+  bool sync; // Read the GA during startup sync and pass the answer to sync_callback
+  callback_id_t sync_callback;
+  bool dirty; // Changed since the last save to EEPROM
+  uint32_t key; // Hash of the name, identifies the config in EEPROM and journal
 } config_t;
 
 typedef struct __feedback_float_options
@@ -334,7 +484,7 @@ typedef struct __feedback_action_options
 typedef struct __feedback
 {
   feedback_type_t type;
-  String name;
+  string_ref_t name;
   enable_condition_t cond;
   void *data;
   union {
@@ -343,12 +493,39 @@ typedef struct __feedback
   } options;
 } feedback_t;
 
+// Callback durations are counted in buckets of up to 64 us, 256 us, ... (factor 4), the last one counts the rest
+#define __CALLBACK_TIMING_BUCKETS 8
+#define __CALLBACK_TIMING_FIRST   64
+
+typedef struct __callback_timing
+{
+  uint32_t buckets[__CALLBACK_TIMING_BUCKETS];
+  uint64_t total; // Sum of all durations in us
+  uint32_t max; // Longest duration in us
+  uint32_t slow; // Calls longer than SLOW_CALLBACK_THRESHOLD
+} callback_timing_t;
+
+// The last call longer than SLOW_CALLBACK_THRESHOLD
+typedef struct __slow_callback
+{
+  callback_id_t id;
+  address_t address; // Group address of the telegram
+  uint32_t duration; // us
+  uint32_t time; // millis() when it returned, 0 if there was none yet
+} slow_callback_t;
+
 typedef struct __callback
 {
   callback_fptr_t fkt;
   enable_condition_t cond;
   void *arg;
-  String name;
+  string_ref_t name;
+  bool sync; // Read all assigned GAs during startup sync
+  uint32_t key; // Hash of the name, identifies the callback of stored assignments
+  uint32_t calls; // Number of telegrams passed to fkt
+#if !DISABLE_CALLBACK_TIMING
+  callback_timing_t timing;
+#endif
 } callback_t;
 
 typedef struct __callback_assignment
@@ -357,6 +534,310 @@ typedef struct __callback_assignment
   callback_id_t callback_id;
 } callback_assignment_t;
 
+typedef struct __cyclic
+{
+  cyclic_fptr_t fkt;
+  void *arg;
+  enable_condition_t cond;
+  uint32_t period; // 0 disables the function
+  unsigned long next_run;
+} cyclic_t;
+
+typedef struct __read_request
+{
+  read_state_t state;
+  address_t address;
+  bool sent; // Reads to the same address are coalesced, only one of them is on the bus at a time
+  unsigned long started; // When the read was sent, or when the result arrived for requests without callback
+  uint16_t timeout;
+  read_result_fptr_t fkt;
+  void *arg;
+  uint8_t data_len;
+  uint8_t data[READ_REQUEST_MAX_DATA];
+} read_request_t;
+
+typedef struct __sync_state
+{
+  bool running;
+  uint8_t round;
+  uint16_t item_count; // Assignments followed by configs
+  uint16_t next_item;
+  uint16_t outstanding;
+  unsigned long next_send;
+  uint8_t *done; // One bit per item
+  sync_done_fptr_t fkt;
+  void *arg;
+} sync_state_t;
+
+typedef enum __eeprom_dirty
+{
+  EEPROM_DIRTY_NONE     = 0,
+  EEPROM_DIRTY_MAGIC    = 1, // EEPROM content is not valid, everything needs to be written
+  EEPROM_DIRTY_PHYSADDR = 2,
+} eeprom_dirty_t;
+
+typedef struct __eeprom_stats
+{
+  uint32_t saves;
+  uint32_t commits;
+  uint32_t bytes_written; // Total over all saves
+  uint16_t last_bytes_written;
+  uint32_t last_commit_time; // Duration of the last commit in us
+  uint32_t last_restore_time; // Duration of the last restore in us
+  uint16_t last_restore_records; // Number of journal records replayed by the last restore
+} eeprom_stats_t;
+
+/**
+ * Parts of loop(), timed separately
+ */
+typedef enum __loop_phase
+{
+  LOOP_PHASE_RECEIVE, // Reading and parsing telegrams
+  LOOP_PHASE_DISPATCH, // Callbacks and read requests of received telegrams
+  LOOP_PHASE_TIMERS, // Read request timeouts, startup sync and cyclic functions
+  LOOP_PHASE_TRANSPORT, // Repetitions and timeouts of point-to-point connections
+  LOOP_PHASE_WEB, // Webserver requests
+  LOOP_PHASE_EVENTS, // Event stream
+  LOOP_PHASE_COUNT,
+} loop_phase_t;
+
+typedef struct __loop_phase_stats
+{
+  uint32_t mean; // Moving average over about the last 16 calls in us, times 16
+  uint32_t max; // Longest in the current window in us
+  uint32_t last_max; // Longest in the previous window in us
+  uint32_t deferred; // Calls in which the phase waited because of the budget
+} loop_phase_stats_t;
+
+/**
+ * Heap around one web route or operation. Sizes are in bytes and saturate at 0xFFFF, the ESP8266 heap is smaller.
+ * The largest free block is 0 on cores before 2.5.0.
+ */
+typedef struct __memory_probe
+{
+  PGM_P name; // Route or operation
+  uint32_t calls;
+  uint16_t heap_before; // Free heap before the last call
+  uint16_t heap_after; // Free heap after the last call
+  uint16_t block_before; // Largest free block before the last call
+  uint16_t block_after; // Largest free block after the last call
+  uint16_t heap_min; // Lowest free heap after any call
+  uint16_t block_min; // Smallest largest free block after any call
+  uint16_t heap_kept_max; // Largest amount of heap a single call did not give back
+} memory_probe_t;
+
+/**
+ * Counters since boot, updated where the events happen so reading them costs nothing
+ */
+typedef struct __metrics
+{
+  uint32_t rx_packets; // UDP packets received on the multicast group
+  uint32_t rx_dropped; // Received packets that were no KNX routing indications carrying data
+  uint32_t rx_telegrams; // Group telegrams passed to read requests and callbacks
+  uint32_t tx_telegrams;
+  uint32_t tx_failed; // Telegrams the UDP stack did not accept
+  uint32_t loops;
+  uint64_t loop_time; // Total duration of all loops in us
+  uint32_t loop_time_max; // Duration of the longest loop in us
+  uint32_t web_requests;
+} metrics_t;
+
+/**
+ * EEPROM format
+ * The magic is followed by records of tag (1 byte), length (1 byte), key (4 bytes) and length bytes of value.
+ * Configs and callbacks are identified by the hash of their name, so records of unknown items are skipped and
+ * items without a record keep their default. The last record is followed by EEPROM_RECORD_END.
+ */
+typedef enum __eeprom_record_tag
+{
+  EEPROM_RECORD_PHYSADDR   = 0x01, // no key, value is the physical address
+  EEPROM_RECORD_ASSIGNMENT = 0x02, // key is the callback key, value is the GA
+  EEPROM_RECORD_CONFIG     = 0x03, // key is the config key, value is flags + value
+  EEPROM_RECORD_END        = 0xFF,
+} eeprom_record_tag_t;
+
+#define EEPROM_RECORD_HEADER_SIZE 6
+
+/**
+ * With USE_CONFIG_SLOTS, the EEPROM image is not committed to the EEPROM sector directly, but alternately to two flash
+ * sectors (the EEPROM sector and the one below it). Each sector starts with an eeprom_slot_t header followed by the
+ * image. The header is written last, so a power cut during a save leaves the previous slot intact.
+ */
+typedef struct __eeprom_slot
+{
+  uint32_t magic;
+  uint32_t generation; // Incremented with every save, restore picks the newest valid slot
+  uint16_t len; // Length of the image
+  uint16_t crc; // Over the image
+} eeprom_slot_t;
+
+/**
+ * Journal format
+ * Each sector starts with a journal_sector_t header, followed by records. Each record is a journal_record_t
+ * followed by len bytes of data, padded to 4 bytes. A new sector always starts with a snapshot of the whole
+ * config, so only the newest sector needs to be replayed on restore.
+ */
+typedef enum __journal_record_type
+{
+  JOURNAL_RECORD_CONFIG           = 0x01, // key is the config key, data is flags + value
+  JOURNAL_RECORD_ASSIGNMENT_COUNT = 0x02, // key is the number of assignments, no data
+  JOURNAL_RECORD_ASSIGNMENT       = 0x03, // key is the assignment id, data is GA high, GA low, callback key
+  JOURNAL_RECORD_PHYSADDR         = 0x04, // no key, data is the physical address
+  JOURNAL_RECORD_FREE             = 0xFF, // erased flash
+} journal_record_type_t;
+
+typedef struct __journal_sector
+{
+  uint32_t magic;
+  uint32_t sequence;
+} journal_sector_t;
+
+typedef struct __journal_record
+{
+  uint8_t type;
+  uint8_t len;
+  uint16_t crc; // Over key and data
+  uint32_t key;
+} journal_record_t;
+
+/**
+ * Matches addresses by their first parts, e.g. all group addresses of main group 1. Only the bits set in the masks
+ * are compared, all zero matches every address.
+ */
+typedef struct __address_filter
+{
+  address_t address;
+  uint8_t mask_high;
+  uint8_t mask_low;
+} address_filter_t;
+
+/**
+ * A telegram kept by the bus monitor
+ */
+typedef struct __monitor_entry
+{
+  uint32_t time; // millis() when received
+  address_t source;
+  address_t destination;
+  uint8_t ct; // knx_command_type_t
+  uint8_t data_len; // Length on the bus, only the first BUS_MONITOR_DATA_LEN bytes are kept
+  uint8_t data[BUS_MONITOR_DATA_LEN];
+} monitor_entry_t;
+
+/**
+ * Telegram sent by a callback during loopback, see __loopback()
+ */
+typedef struct __loopback_entry
+{
+  address_t destination;
+  uint8_t ct; // knx_command_type_t
+  uint8_t data_len;
+  uint8_t data[LOOPBACK_DATA_LEN];
+} loopback_entry_t;
+
+/**
+ * A client of the event stream. Clients whose send buffer is full are skipped instead of waited for: missed
+ * feedback values are sent again on the next tick, missed telegrams are counted and reported.
+ */
+typedef struct __event_client
+{
+  WiFiClient client;
+  bool telegrams; // Also stream received group telegrams
+  address_filter_t filter; // Telegrams are sent if their destination matches
+  bool resync; // Send all feedback values on the next tick
+  uint16_t dropped; // Telegrams dropped since the last report
+  unsigned long last_send;
+} event_client_t;
+
+// Static files of the web ui, see tools/embed_assets.py
+typedef enum __web_asset
+{
+  ASSET_STYLE,
+  ASSET_SCRIPT,
+  ASSET_MONITOR_SCRIPT,
+} web_asset_t;
+
+// Position of a feedback value in the cached page, the value is inserted there when the page is sent
+typedef struct __page_hole
+{
+  uint16_t offset;
+  feedback_id_t id;
+} page_hole_t;
+
+typedef enum __api_resource
+{
+  API_FEEDBACK,
+  API_CONFIG,
+  API_ASSIGNMENTS,
+  API_PHYSADDR,
+  API_CALLBACKS,
+  API_MEMORY,
+} api_resource_t;
+
+typedef enum __transport_state
+{
+  TRANSPORT_STATE_CLOSED,
+  TRANSPORT_STATE_OPEN_IDLE,
+  TRANSPORT_STATE_OPEN_WAIT, // Waiting for the ACK of our last numbered data packet
+} transport_state_t;
+
+typedef struct __transport_connection
+{
+  transport_state_t state;
+  address_t partner;
+  uint8_t seq_send;
+  uint8_t seq_recv;
+  uint8_t repetitions;
+  unsigned long last_activity;
+  unsigned long last_send;
+  // Last unacknowledged numbered data packet, kept for repetitions. Window size is 1.
+  knx_command_type_t pending_ct;
+  uint8_t pending_len;
+  uint8_t pending_data[TRANSPORT_MAX_APDU_LEN];
+  // Answer to a request that arrived before the ACK of the pending packet, sent once the ACK arrived
+  bool deferred;
+  knx_command_type_t deferred_ct;
+  uint8_t deferred_len;
+  uint8_t deferred_data[TRANSPORT_MAX_APDU_LEN];
+} transport_connection_t;
+
+/**
+ * Print that sends a response with chunked transfer encoding. Output is collected in a buffer of WEB_CHUNK_SIZE
+ * bytes, which is sent as one chunk when it is full. Flash strings that do not fit are sent directly from flash.
+ * With capture(), everything sent is also copied to another buffer, e.g. to send it again later.
+ */
+class ChunkedWriter : public Print
+{
+  public:
+    ChunkedWriter(ESP8266WebServer *server) : server(server), len(0), capture_buffer(nullptr) {}
+    void begin(int code, const __FlashStringHelper *content_type);
+    void end();
+
+    void capture(uint8_t *buf, uint16_t size);
+    void capture_pause(bool paused) { capture_paused = paused; }
+    void capture_abort() { capture_buffer = nullptr; }
+    bool captured_all() { return capture_buffer != nullptr; } // False if capturing was aborted or the buffer was too small
+    uint16_t captured() { return capture_len; }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t size) override;
+    using Print::write;
+    size_t print(const __FlashStringHelper *str);
+    using Print::print;
+    void flush();
+
+  private:
+    void copy_to_capture(const uint8_t *data, size_t size, bool pgm);
+
+    ESP8266WebServer *server;
+    uint16_t len;
+    char buffer[WEB_CHUNK_SIZE];
+    uint8_t *capture_buffer;
+    uint16_t capture_size;
+    uint16_t capture_len;
+    bool capture_paused;
+};
+
 class ESPKNXIP {
   public:
     ESPKNXIP();
@@ -367,9 +848,27 @@ class ESPKNXIP {
 
     void save_to_eeprom();
     void restore_from_eeprom();
+    eeprom_stats_t eeprom_stats_get();
+    void memory_report(Print &out = Serial);
+    void loop_report(Print &out = Serial);
+    void loop_budget_set(uint32_t us); // 0 disables, see LOOP_BUDGET
+    void page_invalidate(); // Call when an enable condition changed without a config change, the config page is cached
+
+#if !DISABLE_BUS_MONITOR
+    // Bus monitor, filters are "area[/line[/member]]" and "area[.line[.member]]", empty matches all
+    bool monitor_set_filter(String ga, String source);
+    void monitor_clear();
+#endif
+
+    // Export and import of physical address, assignments and configs
+    size_t config_export(Print &out); // Binary, same format as the EEPROM image
+    size_t config_export_json(Print &out); // Read only, cannot be imported
+    bool   config_import(uint8_t const *data, uint16_t len); // Binary from config_export(), applied only if it is valid
 
     callback_id_t callback_register(String name, callback_fptr_t cb, void *arg = nullptr, enable_condition_t cond = nullptr);
+    callback_id_t callback_register(const __FlashStringHelper *name, callback_fptr_t cb, void *arg = nullptr, enable_condition_t cond = nullptr);
     void          callback_assign(callback_id_t id, address_t val);
+    void          callback_set_sync(callback_id_t id, bool sync = true);
 
     void          physical_address_set(address_t const &addr);
     address_t     physical_address_get();
@@ -380,8 +879,17 @@ class ESPKNXIP {
     config_id_t   config_register_bool(String name, bool _default, enable_condition_t cond = nullptr);
     config_id_t   config_register_options(String name, option_entry_t *options, uint8_t _default, enable_condition_t cond = nullptr);
     config_id_t   config_register_ga(String name, enable_condition_t cond = nullptr);
+    // Same as above, but name and default stay in flash, e.g. config_register_int(F("Interval"), 1000)
+    config_id_t   config_register_string(const __FlashStringHelper *name, uint8_t len, const __FlashStringHelper *_default, enable_condition_t cond = nullptr);
+    config_id_t   config_register_int(const __FlashStringHelper *name, int32_t _default, enable_condition_t cond = nullptr);
+    config_id_t   config_register_bool(const __FlashStringHelper *name, bool _default, enable_condition_t cond = nullptr);
+    config_id_t   config_register_options(const __FlashStringHelper *name, option_entry_t *options, uint8_t _default, enable_condition_t cond = nullptr);
+    config_id_t   config_register_ga(const __FlashStringHelper *name, enable_condition_t cond = nullptr);
+    void          config_set_sync(config_id_t id, callback_id_t cb);
+    void          config_subscribe(config_id_t id, config_changed_fptr_t fkt, void *arg = nullptr);
 
     String        config_get_string(config_id_t id);
+    const char   *config_get_string_view(config_id_t id); // No copy, valid until the next config is registered
     int32_t       config_get_int(config_id_t id);
     bool          config_get_bool(config_id_t id);
     uint8_t       config_get_options(config_id_t id);
@@ -398,8 +906,30 @@ class ESPKNXIP {
     feedback_id_t feedback_register_float(String name, float *value, uint8_t precision = 2, enable_condition_t cond = nullptr);
     feedback_id_t feedback_register_bool(String name, bool *value, enable_condition_t cond = nullptr);
     feedback_id_t feedback_register_action(String name, feedback_action_fptr_t value, void *arg = nullptr, enable_condition_t = nullptr);
+    feedback_id_t feedback_register_int(const __FlashStringHelper *name, int32_t *value, enable_condition_t cond = nullptr);
+    feedback_id_t feedback_register_float(const __FlashStringHelper *name, float *value, uint8_t precision = 2, enable_condition_t cond = nullptr);
+    feedback_id_t feedback_register_bool(const __FlashStringHelper *name, bool *value, enable_condition_t cond = nullptr);
+    feedback_id_t feedback_register_action(const __FlashStringHelper *name, feedback_action_fptr_t value, void *arg = nullptr, enable_condition_t = nullptr);
+
+    // Cyclic functions
+    cyclic_id_t   cyclic_register(uint32_t period, cyclic_fptr_t fkt, void *arg = nullptr, enable_condition_t cond = nullptr);
+    void          cyclic_set_period(cyclic_id_t id, uint32_t period);
+
+    // Read functions
+    // Returns READ_REQUEST_INVALID if no read could be started. Without callback, poll the result and free the slot
+    // with read_request_release(), otherwise it is only freed after READ_REQUEST_RESULT_LIFETIME
+    read_request_id_t read_request(address_t const &address, read_result_fptr_t cb = nullptr, void *arg = nullptr, uint16_t timeout = READ_REQUEST_TIMEOUT);
+    read_state_t      read_request_state(read_request_id_t id);
+    bool              read_request_result(read_request_id_t id, message_t &msg);
+    void              read_request_release(read_request_id_t id);
+
+    // Startup sync functions
+    void          sync_start();
+    bool          sync_running();
+    void          sync_register_done(sync_done_fptr_t fkt, void *arg = nullptr);
 
     // Send functions
+    void loopback_set(loopback_mode_t mode);
     void send(address_t const &receiver, knx_command_type_t ct, uint8_t data_len, uint8_t *data);
 
     void send_1bit(address_t const &receiver, knx_command_type_t ct, uint8_t bit);
@@ -487,12 +1017,90 @@ class ESPKNXIP {
     }
 
   private:
-    void __start();
+    void __start(bool own_server);
+    void __loop_phase_record(loop_phase_t phase, uint32_t duration);
+    uint32_t __loop_phase_max(loop_phase_t phase) { return loop_phases[phase].max > loop_phases[phase].last_max ? loop_phases[phase].max : loop_phases[phase].last_max; }
+    static PGM_P __loop_phase_name(loop_phase_t phase);
+    void __web_on(const __FlashStringHelper *uri, HTTPMethod method, ESP8266WebServer::THandlerFunction fn, ESP8266WebServer::THandlerFunction upload = nullptr);
+    bool __address_filter_parse(String const &str, address_filter_t &filter, bool group);
+    size_t __address_filter_print(Print &out, address_filter_t const &filter, bool group);
+    static bool __address_filter_match(address_filter_t const &filter, address_t const &addr)
+    {
+      return ((addr.bytes.high ^ filter.address.bytes.high) & filter.mask_high) == 0 && ((addr.bytes.low ^ filter.address.bytes.low) & filter.mask_low) == 0;
+    }
     void __loop_knx();
+    void __dispatch(address_t const &destination, knx_command_type_t ct, uint8_t data_len, uint8_t *data);
+    bool __callback_call(callback_id_t id, message_t const &msg);
+#if !DISABLE_CALLBACK_TIMING
+    void __callback_timing_record(callback_id_t id, uint32_t duration, address_t const &destination);
+    static uint32_t __callback_timing_limit(uint8_t bucket) { return (uint32_t)__CALLBACK_TIMING_FIRST << (2 * bucket); }
+#endif
+    void __loopback(cemi_service_t *cemi_data, knx_command_type_t ct);
+    void __send(address_t const &receiver, uint8_t dest_addr_type, knx_communication_type_t comm_type, uint8_t seq_number, uint8_t apci, uint8_t data_len, uint8_t *data);
+
+    // Cyclic functions
+    void __loop_cyclic();
+    void __cyclic_schedule(cyclic_id_t id);
+
+    // Read request functions
+    void __loop_read_requests();
+    void __read_request_send_pending();
+    void __read_request_resolve(address_t const &address, uint8_t data_len, uint8_t *data);
+    void __read_request_finish(read_request_id_t id);
+
+    // Startup sync functions
+    void __loop_sync();
+    bool __sync_item_address(uint16_t item, address_t &address);
+    void __sync_result(read_state_t state, message_t const &msg);
+    void __sync_finish(uint16_t missing);
+    static void __sync_read_result(read_state_t state, message_t const &msg, void *arg);
+    uint32_t __device_hash(uint32_t salt);
+
+#if !DISABLE_BUS_MONITOR
+    // Bus monitor functions
+    void __monitor_capture(cemi_service_t *cemi_data);
+    size_t __json_monitor(Print &out, uint32_t since);
+    void __handle_monitor();
+    void __handle_monitor_api();
+#endif
+
+#if !DISABLE_EVENTS
+    // Event functions
+    void __loop_events();
+    void __event_telegram(cemi_service_t *cemi_data, knx_command_type_t ct, uint8_t data_len, uint8_t *data);
+    uint8_t __event_format_feedback(feedback_id_t id, char *buf, uint8_t size);
+    bool __event_send(event_client_t &c, char const *data, uint16_t len);
+#if !DISABLE_CALLBACK_TIMING
+    void __event_slow_callback(slow_callback_t const &slow);
+#endif
+#endif
+
+    // Transport layer functions
+    void __loop_transport();
+    void __transport_receive(cemi_service_t *cemi_data);
+    void __transport_handle_apdu(cemi_service_t *cemi_data);
+    void __transport_send_control(address_t const &receiver, knx_transport_control_t ctrl, uint8_t seq_number);
+    void __transport_send_data(knx_command_type_t ct, uint8_t data_len, uint8_t *data);
+    void __transport_repeat();
+    void __transport_disconnect();
+
+    // Memory functions
+    uint16_t __config_space_used();
+    bool __memory_read(uint16_t address, uint8_t &val);
+    bool __memory_write(uint16_t address, uint8_t val, bool dry_run);
+    void __memory_write_range(uint16_t address, uint8_t len, uint8_t const *data);
+    bool __memory_assignment_count_valid(uint8_t val, uint16_t address, uint8_t len, uint8_t const *data);
 
     // Webserver functions
     void __loop_webserver();
     void __handle_root();
+    void __handle_asset(web_asset_t asset);
+    void __page_feedback_value(ChunkedWriter &m, feedback_id_t id);
+#if PAGE_CACHE_SIZE > 0
+    void __page_cache_begin(ChunkedWriter &m);
+    void __page_cache_end(ChunkedWriter &m);
+    void __page_cache_send(ChunkedWriter &m);
+#endif
     void __handle_register();
     void __handle_delete();
     void __handle_set();
@@ -507,8 +1115,105 @@ class ESPKNXIP {
 #if !DISABLE_REBOOT_BUTTONS
     void __handle_reboot();
 #endif
+#if !DISABLE_EXPORT_IMPORT
+    void __handle_export();
+    void __handle_import();
+    void __handle_import_upload();
+#endif
+#if !DISABLE_EVENTS
+    void __handle_events();
+#endif
+#if !DISABLE_CALLBACK_TIMING
+    void __handle_timing();
+#endif
+#if !DISABLE_METRICS
+    void __handle_metrics();
+    void __metric(Print &out, PGM_P name, PGM_P type, PGM_P help);
+    void __metric(Print &out, PGM_P name, PGM_P type, PGM_P help, uint32_t value);
+    void __metric_callback_labels(Print &out, callback_id_t id);
+#if !DISABLE_MEMORY_STATS
+    void __metric_probes(Print &out, PGM_P name, size_t offset);
+#endif
+#endif
+#if !DISABLE_MEMORY_STATS
+    void __memory_probe_begin(memory_probe_t &probe);
+    void __memory_probe_end(memory_probe_t &probe);
+    void __memory_probe_print(Print &out, memory_probe_t const &probe);
+    size_t __json_memory_probe(Print &out, memory_probe_t const &probe);
+    size_t __json_memory(Print &out);
+    // Records how deep loop() went when the stack reaches addr, cheap enough for every telegram
+    void __stack_sample(const void *addr) { if (stack_base > (uintptr_t)addr && stack_base - (uintptr_t)addr > stack_max) stack_max = stack_base - (uintptr_t)addr; }
+#endif
+#if !DISABLE_JSON_API
+    void __handle_api(api_resource_t resource);
+    bool __api_not_modified(uint32_t etag);
+    uint32_t __feedback_hash();
+#endif
+
+    void __eeprom_save();
+    void __eeprom_restore();
+    bool __eeprom_records_apply(uint8_t const *data, uint16_t len, bool dry_run);
+    bool __eeprom_slot_commit(uint16_t len);
+    bool __eeprom_slot_read(uint8_t slot, eeprom_slot_t const &header);
+    static uint32_t __eeprom_slot_address(uint8_t slot);
+    static uint32_t __eeprom_sector();
+    static bool __eeprom_slots_usable();
+    static bool __journal_usable();
+    bool __eeprom_write_record(uint32_t &address, eeprom_record_tag_t tag, uint32_t key, uint8_t len, uint8_t const *data);
+    void __eeprom_update(uint32_t address, uint8_t val);
+    void __eeprom_mark_all_dirty();
+    void __eeprom_mark_clean();
+
+    // Export functions
+    size_t __export_record(Print &out, eeprom_record_tag_t tag, uint32_t key, uint8_t len, uint8_t const *data);
+    static size_t __export_json_string(Print &out, PGM_P str);
+    size_t __json_physical_address(Print &out);
+    size_t __json_assignments(Print &out);
+    size_t __json_configs(Print &out);
+    size_t __json_feedbacks(Print &out);
+#if !DISABLE_CALLBACK_TIMING
+    size_t __json_callbacks(Print &out);
+#endif
+
+    // Journal functions
+    void __journal_save();
+    void __journal_restore();
+    bool __journal_append(journal_record_type_t type, uint32_t key, uint8_t len, uint8_t const *data);
+    bool __journal_append_assignment(callback_assignment_id_t id);
+    bool __journal_compact();
+    bool __journal_write_snapshot(uint8_t sector);
+    uint32_t __journal_sector_address(uint8_t sector);
+    static uint16_t __crc16(uint8_t const *data, uint32_t len, uint16_t crc = 0xFFFF);
+
+    void __eeprom_mark_assignments_dirty(callback_assignment_id_t from);
+
+    // Registry functions
+    static bool __registry_reserve(void **items, uint16_t &capacity, uint32_t needed, size_t item_size, uint16_t limit);
+    static void __registry_shrink(void **items, uint16_t &capacity, uint16_t count, size_t item_size);
+    bool __callback_assignments_reserve(uint32_t needed);
+    bool __config_reserve(uint16_t len);
+
+    // String pool functions
+    string_ref_t __string_pool_add(const __FlashStringHelper *str);
+    string_ref_t __string_pool_add(String const &str);
+    const __FlashStringHelper *__string_pool_get(string_ref_t ref);
+    static bool __string_equals(PGM_P a, PGM_P b);
+
+    // Storage index functions
+    static uint32_t __name_hash(const __FlashStringHelper *name);
+    static bool __in_flash(const void *p);
+    void __storage_index_build();
+    config_id_t __config_find_key(uint32_t key);
+    callback_id_t __callback_find_key(uint32_t key);
+    bool __config_restore(config_id_t id, uint8_t len, uint8_t const *data, bool dry_run = false);
 
     void __config_set_flags(config_id_t id, config_flags_t flags);
+    void __config_set_default(config_id_t id);
+    void __config_decode(config_id_t id);
+    config_value_t __config_value_save(config_id_t id, char *str);
+    void __config_notify(config_id_t id, config_value_t const &old_value);
+    void __config_write(config_id_t id, uint8_t offset, uint8_t len, uint8_t const *data);
+    config_id_t __config_find_offset(uint16_t offset);
 
     void __config_set_string(config_id_t id, String &val);
     void __config_set_int(config_id_t id, int32_t val);
@@ -521,21 +1226,111 @@ class ESPKNXIP {
 
     ESP8266WebServer *server;
     address_t physaddr;
+    uint32_t state_version; // Changed with every change of a config, assignment, registration or the physical address, used as ETag and to invalidate the page cache
+
+    uint8_t eeprom_dirty; // See eeprom_dirty_t
+    callback_assignment_id_t eeprom_assignments_dirty_from; // First changed assignment, MAX_CALLBACK_ASSIGNMENTS if unchanged
+    eeprom_stats_t eeprom_stats;
+    metrics_t metrics;
+    loop_phase_stats_t loop_phases[LOOP_PHASE_COUNT];
+    uint32_t loop_budget; // us, 0 if disabled
+    uint32_t loop_dispatch_time; // Time spent in __dispatch during the current call of loop()
+    unsigned long loop_window_end;
+    bool loop_deferred; // Web handling waited in the last call
+#if !DISABLE_CALLBACK_TIMING
+    slow_callback_t slow_callback;
+#endif
+#if !DISABLE_MEMORY_STATS
+    memory_probe_t *memory_probes; // One per web route, in the order they were registered
+    uint16_t memory_probes_count;
+    uint16_t memory_probes_capacity;
+    memory_probe_t memory_save; // save_to_eeprom()
+    uintptr_t stack_base; // Stack pointer on entry of loop(), 0 outside of it
+    uint32_t stack_max; // Deepest stack use below loop() seen in bytes
+#endif
+    uint8_t eeprom_slot; // Slot of the last valid save
+    uint32_t eeprom_generation; // Generation of the last valid save
+#if USE_CONFIG_JOURNAL
+    bool journal_valid; // False if there is no usable sector or the last one has a torn record
+    uint8_t journal_sector; // Active sector
+    uint32_t journal_sequence; // Sequence number of the active sector
+    uint16_t journal_offset; // Next free byte in the active sector
+#endif
     WiFiUDP udp;
+    loopback_mode_t loopback_mode;
+    uint8_t loopback_depth;
+    loopback_entry_t loopback_queue[LOOPBACK_QUEUE_SIZE]; // Sent while dispatching a looped back telegram
+    uint8_t loopback_queue_len;
 
+    // Registries, see __registry_reserve()
     callback_assignment_id_t registered_callback_assignments;
-    callback_assignment_t callback_assignments[MAX_CALLBACK_ASSIGNMENTS];
+    callback_assignment_id_t callback_assignments_capacity;
+    callback_assignment_t *callback_assignments;
 
     callback_id_t registered_callbacks;
-    callback_t callbacks[MAX_CALLBACKS];
+    callback_id_t callbacks_capacity;
+    callback_t *callbacks;
 
     config_id_t registered_configs;
-    uint8_t custom_config_data[MAX_CONFIG_SPACE];
-    uint8_t custom_config_default_data[MAX_CONFIG_SPACE];
-    config_t custom_configs[MAX_CONFIGS];
+    config_id_t custom_configs_capacity;
+    config_t *custom_configs;
+    uint16_t custom_config_data_capacity;
+    uint8_t *custom_config_data;
+
+    // Hash tables to find configs and callbacks by the hash of their name, at most half full
+    uint16_t config_index_size;
+    config_id_t *config_index;
+    uint16_t callback_index_size;
+    callback_id_t *callback_index;
 
     feedback_id_t registered_feedbacks;
-    feedback_t feedbacks[MAX_FEEDBACKS];
+    feedback_id_t feedbacks_capacity;
+    feedback_t *feedbacks;
+
+    // String pool, entries are either a \0 terminated string or STRING_POOL_FLASH followed by a flash pointer
+    uint16_t string_pool_len;
+    uint16_t string_pool_capacity;
+    char *string_pool;
+
+    cyclic_id_t registered_cyclics;
+    cyclic_id_t next_cyclic;
+    cyclic_t cyclics[MAX_CYCLICS];
+
+    read_request_t read_requests[MAX_READ_REQUESTS];
+    sync_state_t sync;
+
+    transport_connection_t transport;
+
+#if !DISABLE_EVENTS
+    event_client_t event_clients[MAX_EVENT_CLIENTS];
+    unsigned long event_next_tick;
+    uint32_t *event_snapshot; // Feedback values sent on the last tick, allocated when the first client connects
+#endif
+
+#if !DISABLE_BUS_MONITOR
+    monitor_entry_t monitor[BUS_MONITOR_SIZE];
+    uint32_t monitor_next; // Number of the next telegram, monitor holds the BUS_MONITOR_SIZE before it
+    address_filter_t monitor_filter_ga;
+    address_filter_t monitor_filter_source;
+#endif
+
+#if PAGE_CACHE_SIZE > 0
+    // Config page without feedback values, allocated on the first request
+    uint8_t *page_cache;
+    uint16_t page_cache_len;
+    page_hole_t *page_cache_holes;
+    feedback_id_t page_cache_holes_count;
+    feedback_id_t page_cache_holes_capacity;
+    uint32_t page_cache_version; // state_version the cache was rendered at
+    bool page_cache_valid; // False if nothing is cached or the page did not fit
+#endif
+
+#if !DISABLE_EXPORT_IMPORT
+    // Upload in progress, allocated only while an import is received
+    uint8_t *import_buffer;
+    uint16_t import_len;
+    bool import_overflow;
+#endif
 
     uint16_t __ntohs(uint16_t);
 };
@@ -0,0 +1,103 @@
+/*
+ * This is an example measuring how long saving the config to EEPROM takes and how many bytes are written per save.
+ * It needs no WiFi connection, the results are printed to the serial console.
+ * This sketch was tested on a WeMos D1 mini
+ */
+
+#include <esp-knx-ip.h>
+
+#define BENCH_CONFIGS 10
+
+config_id_t bool_ids[BENCH_CONFIGS];
+config_id_t int_ids[BENCH_CONFIGS];
+
+void setup() {
+  Serial.begin(115200);
+
+  for (int i = 0; i < BENCH_CONFIGS; ++i)
+  {
+    bool_ids[i] = knx.config_register_bool(String("Bool ") + i, false);
+    int_ids[i] = knx.config_register_int(String("Int ") + i, 0);
+  }
+
+  knx.load();
+
+  Serial.println();
+  Serial.println("EEPROM benchmark");
+#if USE_CONFIG_JOURNAL
+  Serial.println("Mode: journal, bytes are the appended records (unless the journal sectors are part of SPIFFS, see USE_CONFIG_JOURNAL)");
+#elif USE_CONFIG_SLOTS
+  Serial.println("Mode: config slots, every commit writes the whole config (unless slot 1 is part of SPIFFS, see USE_CONFIG_SLOTS)");
+#else
+  Serial.println("Mode: EEPROM, bytes are the changed bytes of the EEPROM buffer");
+#endif
+
+  // With USE_CONFIG_JOURNAL, restore replays the journal records written so far
+  eeprom_stats_t restore_stats = knx.eeprom_stats_get();
+  Serial.print("Restore: ");
+  Serial.print(restore_stats.last_restore_records);
+  Serial.print(" records, ");
+  Serial.print(restore_stats.last_restore_time);
+  Serial.println("us");
+
+  // First save after load writes whatever is not in EEPROM yet
+  bench("Initial save");
+
+  // Nothing changed, no commit should happen
+  bench("Unchanged");
+
+  // One bool changed
+  knx.config_set_bool(bool_ids[0], !knx.config_get_bool(bool_ids[0]));
+  bench("One bool");
+
+  // One int changed
+  knx.config_set_int(int_ids[0], knx.config_get_int(int_ids[0]) + 1);
+  bench("One int");
+
+  // Everything changed
+  for (int i = 0; i < BENCH_CONFIGS; ++i)
+  {
+    knx.config_set_bool(bool_ids[i], !knx.config_get_bool(bool_ids[i]));
+    knx.config_set_int(int_ids[i], knx.config_get_int(int_ids[i]) + 1);
+  }
+  bench("All configs");
+
+  // One assignment added
+  callback_id_t cb = knx.callback_register("Dummy", dummy_cb);
+  knx.callback_assign(cb, knx.GA_to_address(1, 2, 3));
+  bench("One assignment");
+
+  eeprom_stats_t stats = knx.eeprom_stats_get();
+  Serial.print("Total: ");
+  Serial.print(stats.saves);
+  Serial.print(" saves, ");
+  Serial.print(stats.commits);
+  Serial.print(" commits, ");
+  Serial.print(stats.bytes_written);
+  Serial.println(" bytes");
+}
+
+void loop() {
+  delay(1000);
+}
+
+void bench(const char *name)
+{
+  unsigned long start = micros();
+  knx.save_to_eeprom();
+  unsigned long duration = micros() - start;
+
+  eeprom_stats_t stats = knx.eeprom_stats_get();
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(stats.last_bytes_written);
+  Serial.print(" bytes, commit ");
+  Serial.print(stats.last_commit_time);
+  Serial.print("us, save ");
+  Serial.print(duration);
+  Serial.println("us");
+}
+
+void dummy_cb(message_t const &msg, void *arg)
+{
+}
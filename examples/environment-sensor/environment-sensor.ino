@@ -12,8 +12,9 @@ const char* pass = "mypassword";
 
 #define LED_PIN D4
 #define UPDATE_INTERVAL 10000
-
-unsigned long next_change = 0;
+// The update rate can be entered in the web ui, values outside of this range are clamped
+#define MIN_UPDATE_INTERVAL 1000
+#define MAX_UPDATE_INTERVAL 3600000
 
 float last_temp = 0.0;
 float last_hum = 0.0;
@@ -24,6 +25,7 @@ config_id_t hostname_id;
 config_id_t update_rate_id, send_rate_id;
 config_id_t enable_sending_id;
 config_id_t enable_reading_id;
+cyclic_id_t update_cyclic_id;
 
 Adafruit_BME280 bme;
 
@@ -55,7 +57,7 @@ void setup() {
   }
 
   // Init WiFi
-  WiFi.hostname(knx.config_get_string(hostname_id));
+  WiFi.hostname(knx.config_get_string_view(hostname_id));
   WiFi.begin(ssid, pass);
 
   Serial.println("");
@@ -72,6 +74,13 @@ void setup() {
   }
   digitalWrite(LED_PIN, HIGH);
 
+  // Read and send the sensor values periodically
+  update_cyclic_id = knx.cyclic_register(update_period(knx.config_get_int(update_rate_id)), update_sensor);
+
+  // Follow changes made in the web ui, no need to read the config in loop()
+  knx.config_subscribe(hostname_id, hostname_changed);
+  knx.config_subscribe(update_rate_id, update_rate_changed);
+
   // Start knx
   knx.start();
 
@@ -82,34 +91,50 @@ void setup() {
 
 void loop() {
   knx.loop();
-  
-  unsigned long now = millis();
 
-  if (next_change < now)
-  {
-    next_change = now + knx.config_get_int(update_rate_id);
+  delay(50);
+}
 
-    last_temp = bme.readTemperature();
-    last_hum = bme.readHumidity();
-    last_pres = bme.readPressure()/100.0f;
+void update_sensor(void *arg)
+{
+  last_temp = bme.readTemperature();
+  last_hum = bme.readHumidity();
+  last_pres = bme.readPressure()/100.0f;
+
+  Serial.print("T: ");
+  Serial.print(last_temp);
+  Serial.print("°C H: ");
+  Serial.print(last_hum);
+  Serial.print("% P: ");
+  Serial.print(last_pres);
+  Serial.println("hPa");
+
+  if (knx.config_get_bool(enable_sending_id))
+  {
+    knx.write_2byte_float(knx.config_get_ga(temp_ga), last_temp);
+    knx.write_2byte_float(knx.config_get_ga(hum_ga), last_hum);
+    knx.write_2byte_float(knx.config_get_ga(pres_ga), last_pres);
+  }
+}
 
-    Serial.print("T: ");
-    Serial.print(last_temp);
-    Serial.print("°C H: ");
-    Serial.print(last_hum);
-    Serial.print("% P: ");
-    Serial.print(last_pres);
-    Serial.println("hPa");
+void hostname_changed(config_id_t id, config_value_t const &old_value, config_value_t const &new_value, void *arg)
+{
+  WiFi.hostname(new_value.str);
+}
 
-    if (knx.config_get_bool(enable_sending_id))
-    {
-      knx.write_2byte_float(knx.config_get_ga(temp_ga), last_temp);
-      knx.write_2byte_float(knx.config_get_ga(hum_ga), last_hum);
-      knx.write_2byte_float(knx.config_get_ga(pres_ga), last_pres);
-    }
-  }
+void update_rate_changed(config_id_t id, config_value_t const &old_value, config_value_t const &new_value, void *arg)
+{
+  knx.cyclic_set_period(update_cyclic_id, update_period(new_value.i));
+}
 
-  delay(50);
+uint32_t update_period(int32_t ms)
+{
+  // A zero or negative value would become a huge period or one that runs on every loop
+  if (ms < MIN_UPDATE_INTERVAL)
+    return MIN_UPDATE_INTERVAL;
+  if (ms > MAX_UPDATE_INTERVAL)
+    return MAX_UPDATE_INTERVAL;
+  return ms;
 }
 
 bool show_periodic_options()
@@ -69,18 +69,25 @@ void setup()
   Serial.begin(115200);
 
   // Register the config options
-  hostname_id = knx.config_register_string("Hostname", 20, String("sonoff"));
-  type_id = knx.config_register_options("Type", type_options, SONOFF_TYPE_BASIC);
+  // Names and defaults wrapped in F() stay in flash
+  hostname_id = knx.config_register_string(F("Hostname"), 20, F("sonoff"));
+  type_id = knx.config_register_options(F("Type"), type_options, SONOFF_TYPE_BASIC);
   
-  channels[0].status_ga_id = knx.config_register_ga("Channel 1 Status GA");
-  channels[1].status_ga_id = knx.config_register_ga("Channel 2 Status GA", is_4ch_or_4ch_pro);
-  channels[2].status_ga_id = knx.config_register_ga("Channel 3 Status GA", is_4ch_or_4ch_pro);
-  channels[3].status_ga_id = knx.config_register_ga("Channel 4 Status GA", is_4ch_or_4ch_pro);
-
-  knx.callback_register("Channel 1", channel_cb, &channels[0]);
-  knx.callback_register("Channel 2", channel_cb, &channels[1], is_4ch_or_4ch_pro);
-  knx.callback_register("Channel 3", channel_cb, &channels[2], is_4ch_or_4ch_pro);
-  knx.callback_register("Channel 4", channel_cb, &channels[3], is_4ch_or_4ch_pro);
+  channels[0].status_ga_id = knx.config_register_ga(F("Channel 1 Status GA"));
+  channels[1].status_ga_id = knx.config_register_ga(F("Channel 2 Status GA"), is_4ch_or_4ch_pro);
+  channels[2].status_ga_id = knx.config_register_ga(F("Channel 3 Status GA"), is_4ch_or_4ch_pro);
+  channels[3].status_ga_id = knx.config_register_ga(F("Channel 4 Status GA"), is_4ch_or_4ch_pro);
+
+  callback_id_t ch1 = knx.callback_register(F("Channel 1"), channel_cb, &channels[0]);
+  callback_id_t ch2 = knx.callback_register(F("Channel 2"), channel_cb, &channels[1], is_4ch_or_4ch_pro);
+  callback_id_t ch3 = knx.callback_register(F("Channel 3"), channel_cb, &channels[2], is_4ch_or_4ch_pro);
+  callback_id_t ch4 = knx.callback_register(F("Channel 4"), channel_cb, &channels[3], is_4ch_or_4ch_pro);
+
+  // Read the current state of all channels after start
+  knx.callback_set_sync(ch1);
+  knx.callback_set_sync(ch2);
+  knx.callback_set_sync(ch3);
+  knx.callback_set_sync(ch4);
 
   knx.feedback_register_bool("Channel 1 is on", &(channels[0].state));
   knx.feedback_register_action("Toogle channel 1", toggle_chan, &channels[0]);
@@ -92,9 +99,12 @@ void setup()
   knx.feedback_register_action("Toogle channel 4", toggle_chan, &channels[3], is_4ch_or_4ch_pro);
 
   knx.load();
+  knx.memory_report();
 
   // Init WiFi
-  WiFi.hostname(knx.config_get_string(hostname_id));
+  WiFi.hostname(knx.config_get_string_view(hostname_id));
+  // Apply a hostname changed in the web ui without a reboot
+  knx.config_subscribe(hostname_id, hostname_changed);
   WiFi.begin(ssid, pass);
 
   Serial.println("");
@@ -134,6 +144,11 @@ void loop()
   delay(50);
 }
 
+void hostname_changed(config_id_t id, config_value_t const &old_value, config_value_t const &new_value, void *arg)
+{
+  WiFi.hostname(new_value.str);
+}
+
 bool is_basic_or_s20()
 {
   uint8_t type = knx.config_get_options(type_id);
@@ -177,6 +192,11 @@ void channel_cb(message_t const &msg, void *arg)
       digitalWrite(chan->pin, chan->state ? HIGH : LOW);
       knx.write_1bit(knx.config_get_ga(chan->status_ga_id), chan->state);
       break;
+    case KNX_CT_ANSWER:
+      // Answer to the startup sync
+      chan->state = msg.data[0];
+      digitalWrite(chan->pin, chan->state ? HIGH : LOW);
+      break;
      case KNX_CT_READ:
       knx.answer_1bit(msg.received_on, chan->state);
   }
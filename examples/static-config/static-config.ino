@@ -14,8 +14,6 @@ const char* pass = "mypassword";
 #define LED_PIN D4
 #define UPDATE_INTERVAL 10000
 
-unsigned long next_change = 0;
-
 float last_temp = 0.0;
 float last_hum = 0.0;
 float last_pres = 0.0;
@@ -68,6 +66,9 @@ void setup() {
   }
   digitalWrite(LED_PIN, HIGH);
 
+  // Read and send the sensor values periodically
+  knx.cyclic_register(UPDATE_INTERVAL, update_sensor);
+
   // Start knx, disable webserver by passing nullptr
   knx.start(nullptr);
 
@@ -78,33 +79,29 @@ void setup() {
 
 void loop() {
   knx.loop();
-  
-  unsigned long now = millis();
-
-  if (next_change < now)
-  {
-    next_change = now + UPDATE_INTERVAL;
-
-    last_temp = bme.readTemperature();
-    last_hum = bme.readHumidity();
-    last_pres = bme.readPressure()/100.0f;
-
-    Serial.print("T: ");
-    Serial.print(last_temp);
-    Serial.print("°C H: ");
-    Serial.print(last_hum);
-    Serial.print("% P: ");
-    Serial.print(last_pres);
-    Serial.println("hPa");
-
-    knx.write_2byte_float(temp_ga, last_temp);
-    knx.write_2byte_float(hum_ga, last_hum);
-    knx.write_2byte_float(pres_ga, last_pres);
-  }
 
   delay(50);
 }
 
+void update_sensor(void *arg)
+{
+  last_temp = bme.readTemperature();
+  last_hum = bme.readHumidity();
+  last_pres = bme.readPressure()/100.0f;
+
+  Serial.print("T: ");
+  Serial.print(last_temp);
+  Serial.print("°C H: ");
+  Serial.print(last_hum);
+  Serial.print("% P: ");
+  Serial.print(last_pres);
+  Serial.println("hPa");
+
+  knx.write_2byte_float(temp_ga, last_temp);
+  knx.write_2byte_float(hum_ga, last_hum);
+  knx.write_2byte_float(pres_ga, last_pres);
+}
+
 void temp_cb(message_t const &msg, void *arg)
 {
   switch (msg.ct)
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Embeds the static files of the web ui (tools/web) into esp-knx-ip-assets.h.
+
+The files are minified and gzip compressed here, so the device sends them as they are stored in flash.
+Run this after changing a file in tools/web and commit the generated header with it:
+
+    python3 tools/embed_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB = os.path.join(ROOT, 'tools', 'web')
+OUT = os.path.join(ROOT, 'esp-knx-ip-assets.h')
+
+# File name, C identifier, content type
+ASSETS = [
+    ('style.css', 'style_css', 'text/css'),
+    ('app.js', 'app_js', 'application/javascript'),
+    ('monitor.js', 'monitor_js', 'application/javascript'),
+]
+
+
+def minify_css(src):
+    src = re.sub(r'/\*.*?\*/', '', src, flags=re.S)
+    src = re.sub(r'\s+', ' ', src)
+    src = re.sub(r'\s*([{};:,>])\s*', r'\1', src)
+    return src.replace(';}', '}').strip()
+
+
+def minify_js(src):
+    # Only comments and indentation are removed, which is safe for any script without a real parser
+    src = re.sub(r'/\*.*?\*/', '', src, flags=re.S)
+    lines = (line.strip() for line in src.splitlines())
+    return '\n'.join(line for line in lines if line and not line.startswith('//'))
+
+
+def compress(data):
+    # mtime 0 keeps the output identical for identical input
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('  ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    version = hashlib.sha1()
+    parts = []
+    for name, ident, content_type in ASSETS:
+        with open(os.path.join(WEB, name), encoding='utf-8') as f:
+            src = f.read()
+        minified = minify_css(src) if name.endswith('.css') else minify_js(src)
+        data = compress(minified.encode('utf-8'))
+        version.update(data)
+        parts.append('// %s, %d bytes minified, %d bytes compressed\n' % (name, len(minified), len(data)))
+        parts.append('#define __ASSET_%s_TYPE "%s"\n' % (ident.upper(), content_type))
+        parts.append('static const uint8_t __asset_%s[] PROGMEM = {\n%s\n};\n\n' % (ident, c_array(data)))
+
+    with open(OUT, 'w', encoding='utf-8', newline='\n') as f:
+        f.write('/**\n')
+        f.write(' * esp-knx-ip library for KNX/IP communication on an ESP8266\n')
+        f.write(' * Author: Nico Weichbrodt <envy>\n')
+        f.write(' * License: MIT\n')
+        f.write(' *\n')
+        f.write(' * Generated by tools/embed_assets.py from tools/web, do not edit.\n')
+        f.write(' */\n\n')
+        f.write('#ifndef ESP_KNX_IP_ASSETS_H\n#define ESP_KNX_IP_ASSETS_H\n\n')
+        f.write('// Changes with the content, appended to the asset urls so cached copies are replaced after an update\n')
+        f.write('#define __ASSETS_VERSION "%s"\n\n' % version.hexdigest()[:8])
+        f.write(''.join(parts))
+        f.write('#endif\n')
+
+
+if __name__ == '__main__':
+    main()
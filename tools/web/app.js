@@ -0,0 +1,26 @@
+/*
+ * Script of the web ui. Keeps the feedback values current without reloading the page,
+ * the stream path is passed in the data-events attribute of the script tag.
+ */
+(function () {
+  var events = document.currentScript && document.currentScript.getAttribute('data-events');
+  if (!events || !window.EventSource) {
+    return;
+  }
+  new EventSource(events).addEventListener('feedback', function (e) {
+    var d = JSON.parse(e.data);
+    var s = document.getElementById('fb' + d.id);
+    if (!s) {
+      return;
+    }
+    if (d.value === true) {
+      s.textContent = 'True';
+    } else if (d.value === false) {
+      s.textContent = 'False';
+    } else if (d.value === null) {
+      s.textContent = 'nan';
+    } else {
+      s.textContent = d.value;
+    }
+  });
+})();
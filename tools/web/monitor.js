@@ -0,0 +1,58 @@
+/*
+ * Script of the bus monitor page. Asks for new telegrams every second and adds them to the table,
+ * the api path is passed in the data-api attribute of the script tag.
+ */
+(function () {
+  var api = document.currentScript && document.currentScript.getAttribute('data-api');
+  var body = document.getElementById('telegrams');
+  var types = ['Read', 'Answer', 'Write'];
+  var next = 0;
+  var maxRows = 200;
+  if (!api || !body) {
+    return;
+  }
+
+  function cell(row, text) {
+    row.insertCell(-1).textContent = text;
+  }
+
+  function note(text) {
+    var row = body.insertRow(0);
+    var c = row.insertCell(-1);
+    c.colSpan = 5;
+    c.className = 'note';
+    c.textContent = text;
+  }
+
+  function poll() {
+    var req = new XMLHttpRequest();
+    req.onload = function () {
+      if (req.status === 200) {
+        var d = JSON.parse(req.responseText);
+        if (d.lost > 0 && next > 0) {
+          note(d.lost + ' telegrams not shown');
+        }
+        d.telegrams.forEach(function (t) {
+          var row = body.insertRow(0);
+          cell(row, t.time);
+          cell(row, t.source);
+          cell(row, t.destination);
+          cell(row, types[t.ct] || ('0x' + t.ct.toString(16)));
+          cell(row, t.data + (t.length * 2 > t.data.length ? '…' : ''));
+        });
+        next = d.next;
+        while (body.rows.length > maxRows) {
+          body.deleteRow(-1);
+        }
+      }
+      setTimeout(poll, 1000);
+    };
+    req.onerror = function () {
+      setTimeout(poll, 5000);
+    };
+    req.open('GET', api + '?since=' + next);
+    req.send();
+  }
+
+  poll();
+})();